@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+// Uma arena aloca memória sequencialmente em blocos grandes e libera todos os
+// blocos de uma só vez, de modo que dados com o mesmo tempo de vida (como os
+// textos dos pontos de recarga) não precisam ser liberados individualmente
+
+// Tamanho padrão de cada bloco da arena
+#define ARENA_BLOCKSZ (64 * 1024)
+
+// Bloco de memória da arena, encadeado ao bloco anterior
+typedef struct ArenaBlock {
+    struct ArenaBlock* prev;    // Bloco alocado anteriormente
+    size_t size;                // Capacidade de data
+    size_t used;                // Bytes de data em uso
+    max_align_t data[];         // Área alocável
+} ArenaBlock;
+
+// Estrutura que representa uma arena
+typedef struct {
+    ArenaBlock* head;   // Bloco atual
+    size_t used;        // Bytes entregues pela arena
+    size_t reserved;    // Bytes alocados para os blocos
+} Arena;
+
+// Arena vazia, que não precisa ser inicializada
+#define EMPTYARENA (Arena){NULL, 0, 0}
+
+// Aloca size bytes da arena, alinhados para qualquer tipo
+void* arena_alloc(Arena* a, size_t size);
+
+// Copia a string s para a arena
+char* arena_strdup(Arena* a, const char* s);
+
+// Transfere todos os blocos da arena src para a arena dst, que passa a ser
+// responsável por liberá-los; src volta a ficar vazia
+void arena_merge(Arena* dst, Arena* src);
+
+// Libera todos os blocos da arena, que volta a ficar vazia
+void arena_release(Arena* a);
+
+// Retorna o número de bytes alocados para os blocos da arena
+size_t arena_memory(const Arena* a);
+
+#endif
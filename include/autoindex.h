@@ -0,0 +1,34 @@
+#ifndef AUTOINDEX_H
+#define AUTOINDEX_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include "boundary.h"
+#include "station.h"
+#include "heap.h"
+#include "spindex.h"
+#include "quadtree.h"
+#include "scan.h"
+
+// O custo da varredura praticamente não depende de k, enquanto o número de
+// nós visitados pela quadtree cresce com k, de modo que a varredura passa a
+// ser mais rápida a partir de um k que cresce com o número n de pontos de
+// recarga. Esse k foi medido com tools/knnbench (make bench) para algumas
+// bases, listadas em autoindex.c, e é interpolado entre elas em escala 
+// logarítmica (e extrapolado pelas duas medições mais próximas fora delas).
+// Retorna o número de vizinhos a partir do qual a varredura linear é mais
+// rápida que a quadtree em uma base de n pontos de recarga
+double autoindex_crossover(long n);
+
+// Indica se a consulta pelos k vizinhos mais próximos deve usar a varredura
+// linear, e não a quadtree
+bool autoindex_use_scan(long k);
+
+// Motor que mantém a quadtree e a varredura linear e escolhe, a cada
+// consulta, a mais rápida para o tamanho da base e o número de vizinhos; as
+// demais operações usam a quadtree
+extern const SpatialIndex auto_index;
+
+#endif
@@ -14,12 +14,40 @@ typedef struct {
     double y_max; // Coordenada máxima no eixo y
 } Boundary;
 
+// Definição de limites inválidos
+#define INVALIDBOUNDARY (Boundary) {0, 0, 0, 0}
+
+// Quadrantes de um retângulo, na ordem em que os filhos de um nó são
+// armazenados na QuadTree
+enum { QUAD_NW = 0, QUAD_NE = 1, QUAD_SW = 2, QUAD_SE = 3 };
+
 // Função que verifica se um ponto (x, y) está contido dentro dos limites do 
 // retângulo (Boundary)
 bool boundary_contains(Boundary* bd, double x, double y); 
 
+// Função que retorna os limites do quadrante q do retângulo (Boundary), 
+// obtidos pela divisão no ponto médio
+Boundary boundary_quadrant(Boundary* bd, int q);
+
+// Função que retorna o quadrante do retângulo (Boundary) em que o ponto 
+// (x, y) se encontra
+int boundary_quadrant_of(Boundary* bd, double x, double y);
+
+// Funções equivalentes às anteriores para a divisão do retângulo em um ponto
+// (sx, sy) qualquer
+Boundary boundary_split(Boundary* bd, int q, double sx, double sy);
+int boundary_split_of(double x, double y, double sx, double sy);
+
+// Função que calcula a distância mínima de um ponto (x, y) até os limites do
+// retângulo (Boundary), zero se o ponto estiver dentro dele
+double boundary_min_dist(Boundary* boundary, double x, double y);
+
 // Função que verifica se um retângulo (Boundary) pode conter um ponto mais 
 // próximo que uma distância máxima (max_dist)
 bool can_contain_closer_point(Boundary* boundary, double x, double y, double max_dist);
 
+// Função que verifica se o segmento (x0, y0)-(x1, y1) toca o retângulo 
+// fechado (Boundary)
+bool boundary_hits_segment(const Boundary* bd, double x0, double y0, double x1, double y1);
+
 #endif 
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "station.h"
+
+// Os atributos textuais dos pontos de recarga (região, bairro e tipo de 
+// logradouro) são codificados em dicionários, e cada ponto de recarga passa
+// a ter um código por atributo. Um filtro compara um único atributo
+
+// Campos sobre os quais um filtro pode ser aplicado
+typedef enum {
+    FILTER_NONE = 0,    // Sem filtro
+    FILTER_REGIO,       // nome_regio igual ao valor
+    FILTER_BAIRRO,      // nome_bairr igual ao valor
+    FILTER_TIPO,        // sigla_tipo igual ao valor
+    FILTER_CEP,         // cep começando pelo prefixo
+    FILTER_NFIELDS
+} FilterField;
+
+// Estrutura que representa um filtro sobre os pontos de recarga
+typedef struct {
+    FilterField field;  // Campo filtrado
+    int code;           // Código do valor no dicionário do campo (-1 se o 
+                        // valor não ocorre em nenhum ponto de recarga)
+    int cep_min;        // Menor CEP com o prefixo
+    int cep_max;        // Maior CEP com o prefixo
+} Filter;
+
+// Número de palavras de 64 bits do resumo de cada campo textual. Cada valor
+// ocupa o bit de posição igual a seu código no dicionário, módulo o número 
+// de bits do campo, de modo que o resumo é exato enquanto o campo tiver no
+// máximo esse número de valores; região e tipo de logradouro têm poucos 
+// valores, e bairro, algumas centenas
+#define FILTER_REGIOWORDS 1
+#define FILTER_BAIRROWORDS 4
+#define FILTER_TIPOWORDS 1
+#define FILTER_SUMMARYWORDS (FILTER_REGIOWORDS + FILTER_BAIRROWORDS + FILTER_TIPOWORDS)
+
+// Resumo dos atributos de um conjunto de pontos de recarga, usado para
+// descartar conjuntos que não podem satisfazer um filtro
+typedef struct {
+    uint64_t attrs[FILTER_SUMMARYWORDS]; // Bits dos valores presentes de cada
+                                         // campo, um campo após o outro
+    int32_t cep_min;    // Menor CEP do conjunto
+    int32_t cep_max;    // Maior CEP do conjunto
+} AttrSummary;
+
+// Resumo de um conjunto vazio
+#define EMPTYSUMMARY (AttrSummary){{0}, INT32_MAX, INT32_MIN}
+
+// Constrói os dicionários e codifica os atributos de todos os pontos de 
+// recarga armazenados
+void filter_build();
+
+// Destroi os dicionários, liberando a memória alocada
+void filter_destroy();
+
+// Retorna o número de bytes alocados para os dicionários e códigos
+size_t filter_memory();
+
+// Prepara um filtro sobre o campo de nome name ("regiao", "bairro", "tipo" 
+// ou "cep") com o valor value; retorna 0 em caso de sucesso ou -1 se o campo
+// ou o valor forem inválidos
+int filter_parse(Filter* f, const char* name, const char* value);
+
+// Indica se o ponto de recarga id satisfaz o filtro (NULL satisfaz sempre)
+bool filter_match(const Filter* f, long id);
+
+// Antecipa a leitura, para a cache, dos códigos do ponto de recarga id 
+// usados pelo filtro f, sem bloquear
+void filter_prefetch(const Filter* f, long id);
+
+// Indica se algum ponto do conjunto resumido por s pode satisfazer o filtro
+bool filter_may_match(const Filter* f, const AttrSummary* s);
+
+// Retorna o resumo dos atributos do ponto de recarga id
+AttrSummary filter_summary(long id);
+
+// Acrescenta ao resumo s os pontos do resumo other
+void filter_summary_merge(AttrSummary* s, const AttrSummary* other);
+
+#endif
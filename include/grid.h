@@ -0,0 +1,46 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "boundary.h"
+#include "station.h"
+#include "heap.h"
+#include "spindex.h"
+
+// Número médio de pontos de recarga desejado por célula da grade
+#define GRID_POINTS_PER_CELL 2
+
+// Ponto armazenado em uma célula da grade
+typedef struct {
+    double x;           // Coordenada x do ponto
+    double y;           // Coordenada y do ponto
+    int32_t key;        // Índice do ponto de recarga
+} GridPoint;
+
+// Constrói a grade uniforme sobre os limites bd (estendidos, se necessário,
+// para conter todos os pontos), com o tamanho das células definido pela
+// densidade de pontos de recarga
+void grid_build(Boundary bd);
+
+// Destroi a grade, liberando a memória alocada
+void grid_destroy();
+
+// Retorna o número de bytes alocados para a grade
+size_t grid_memory();
+
+// Busca um ponto de recarga pelo identificador na célula que contém as 
+// coordenadas (x, y) e retorna seu índice ou INVALIDSTATION
+long grid_search(char* idend, double x, double y);
+
+// Encontra os k pontos mais próximos das coordenadas (x, y) que satisfazem o
+// filtro, expandindo anéis de células a partir da célula de (x, y), armazena
+// os resultados no vetor result e retorna quantos foram encontrados
+long grid_knn(double x, double y, long k, const Filter* filter, Neighbor* result);
+
+// A grade uniforme como motor de índice espacial
+extern const SpatialIndex grid_index;
+
+#endif
@@ -5,12 +5,12 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdbool.h>
-#include "qnode.h"
 
 // Estrutura que representa um vizinho na busca k-NN (k-nearest neighbors)
 typedef struct {
-    nodeaddr_t addr; // Endereço do nó na QuadTree
-    double dist;     // Distância do nó até o ponto de referência
+    long id;         // Identificador do ponto de recarga (ou endereço do nó 
+                     // do índice, durante a busca)
+    double dist;     // Distância do ponto até o ponto de referência
 } Neighbor;
 
 // Max heap.
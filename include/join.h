@@ -0,0 +1,27 @@
+#ifndef JOIN_H
+#define JOIN_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "boundary.h"
+#include "heap.h"
+#include "spindex.h"
+#include "morton.h"
+
+// Número de blocos de consultas por thread, para equilibrar a carga entre as
+// threads quando a densidade de pontos varia pela cidade
+#define JOIN_CHUNKS_PER_THREAD 8
+
+// Encontra os k pontos de recarga ativos mais próximos de cada uma das nq 
+// consultas (xs[i], ys[i]) usando o motor ix. As consultas são ordenadas pelo
+// código de Morton dentro dos limites bd e divididas em blocos contíguos, 
+// processados por nthreads threads; cada bloco é resolvido pela junção do 
+// motor (ou consulta a consulta, se o motor não oferecer junção). Os 
+// vizinhos da consulta i ficam em result[i * k], em ordem de distância, e
+// sua quantidade em found[i]
+void join_knn(const SpatialIndex* ix, Boundary* bd, const double* xs, const double* ys, long nq, long k,
+              int nthreads, Neighbor* result, long* found);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "station.h"
+
+// Tipos de evento registrados no diário. Os valores fazem parte do formato
+// do arquivo e não devem ser alterados; novos eventos (por exemplo, inserção
+// e remoção de pontos) recebem novos valores
+#define JOURNAL_ACTIVATE 1
+#define JOURNAL_DEACTIVATE 2
+
+// Número de eventos acumulados em memória que força a gravação do grupo
+#define JOURNAL_GROUP 256
+
+// Número de eventos no diário que dispara um checkpoint
+#define JOURNAL_CHECKPOINT 65536
+
+// Função que aplica um evento de ativação ou desativação durante a 
+// recuperação
+typedef void (*journal_apply)(long id, bool ativo);
+
+// Abre o diário no caminho path. Se existirem, o snapshot (path.snap) e os 
+// eventos do diário são reaplicados, nessa ordem, sobre os pontos de recarga
+// recém-carregados da base por meio de apply. Retorna 0 em caso de sucesso 
+// ou -1 se o diário não puder ser aberto ou não corresponder à base
+int journal_open(const char* path, journal_apply apply);
+
+// Acrescenta um evento ao diário. O evento fica em memória até a próxima 
+// gravação do grupo
+void journal_append(int op, long id);
+
+// Grava em disco, com uma única sincronização, todos os eventos acumulados e,
+// se o diário estiver longo, faz um checkpoint
+void journal_commit();
+
+// Grava um snapshot do estado de todos os pontos de recarga e esvazia o 
+// diário
+void journal_checkpoint();
+
+// Grava os eventos pendentes e fecha o diário
+void journal_close();
+
+#endif
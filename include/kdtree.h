@@ -0,0 +1,45 @@
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "boundary.h"
+#include "station.h"
+#include "heap.h"
+#include "spindex.h"
+
+// Nó da k-d tree estática. A árvore é implícita: para um intervalo [lo, hi)
+// do vetor, o nó na posição mediana (lo + hi) / 2 divide o intervalo, e os 
+// subintervalos à esquerda e à direita são suas subárvores
+typedef struct {
+    double x;           // Coordenada x do ponto
+    double y;           // Coordenada y do ponto
+    int32_t key;        // Índice do ponto de recarga
+    int32_t axis;       // Eixo de divisão (0 para x, 1 para y)
+} KdNode;
+
+// Constrói a k-d tree balanceada sobre todos os pontos de recarga, dividindo
+// cada intervalo pela mediana do eixo de maior amplitude
+void kdtree_build(Boundary bd);
+
+// Destroi a k-d tree, liberando a memória alocada
+void kdtree_destroy();
+
+// Retorna o número de bytes alocados para a k-d tree
+size_t kdtree_memory();
+
+// Busca um ponto de recarga pelo identificador, a partir das coordenadas 
+// (x, y), e retorna seu índice ou INVALIDSTATION
+long kdtree_search(char* idend, double x, double y);
+
+// Encontra os k pontos mais próximos das coordenadas (x, y) que satisfazem o
+// filtro, armazena os resultados no vetor result e retorna quantos foram
+// encontrados
+long kdtree_knn(double x, double y, long k, const Filter* filter, Neighbor* result);
+
+// A k-d tree como motor de índice espacial
+extern const SpatialIndex kdtree_index;
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fases em que o tempo de cada comando é dividido
+enum { LAT_PARSE = 0, LAT_SEARCH = 1, LAT_OUTPUT = 2, LAT_TOTAL = 3, LAT_NPHASES = 4 };
+
+// Número de classes de n para as consultas C: a classe c contém os valores
+// de n em [2^c, 2^(c+1)), e a última contém também os maiores
+#define LAT_NCLASSES 12
+
+// Séries de histogramas: A, D e uma por classe de n das consultas C
+#define LAT_NSERIES (2 + LAT_NCLASSES)
+
+// Histograma com baldes logarítmicos: cada potência de 2 é dividida em 
+// LAT_SUBBUCKETS baldes, o que limita o erro relativo a 25%
+#define LAT_SUBBUCKETS 4
+#define LAT_BUCKETS (LAT_SUBBUCKETS * 64)
+
+typedef struct {
+    uint64_t count;                 // Número de amostras
+    uint64_t max;                   // Maior amostra (ns)
+    uint64_t sum;                   // Soma das amostras (ns)
+    uint64_t buckets[LAT_BUCKETS];  // Número de amostras por balde
+} Histogram;
+
+// Função que fornece os contadores acumulados de faltas de página e de 
+// acertos no pool de páginas
+typedef void (*latency_page_counter)(uint64_t* faults, uint64_t* hits);
+
+// Passa a registrar, para cada comando, as faltas de página e os acertos no
+// pool informados por counter; o relatório inclui então a distribuição das 
+// faltas por comando e a taxa de acertos de cada série
+void latency_track_pages(latency_page_counter counter);
+
+// Recupera os contadores acumulados de páginas (zero se não houver contador)
+void latency_page_counts(uint64_t* faults, uint64_t* hits);
+
+// Registra as faltas de página e os acertos de um comando na série
+void latency_record_pages(int series, uint64_t faults, uint64_t hits);
+
+// Retorna o instante atual em nanossegundos (relógio monotônico)
+uint64_t latency_now();
+
+// Retorna a série correspondente ao comando op ('A', 'D' ou 'C') e, para 
+// consultas, ao número n de pontos solicitados
+int latency_series(char op, long n);
+
+// Registra uma amostra de ns nanossegundos na fase phase da série
+void latency_record(int series, int phase, uint64_t ns);
+
+// Inicia a medição de um comando
+void latency_begin();
+
+// Atribui à fase phase o tempo decorrido desde a última marcação
+void latency_mark(int phase);
+
+// Encerra a medição do comando, registrando o tempo de cada fase e o total
+// na série
+void latency_end(int series);
+
+// Escreve os percentis p50, p90, p99 e o máximo de cada série e fase, em 
+// microssegundos, no formato JSON
+void latency_dump(FILE* out);
+
+// Define o arquivo em que o relatório é escrito ao receber SIGUSR1 (ou a 
+// saída de erro, se path for NULL) e instala o tratador do sinal
+void latency_install_signal(const char* path);
+
+// Escreve o relatório se SIGUSR1 foi recebido desde a última chamada. Deve 
+// ser chamada entre comandos
+void latency_poll();
+
+// Escreve o relatório no arquivo path
+void latency_dump_file(const char* path);
+
+#endif
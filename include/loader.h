@@ -0,0 +1,40 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "station.h"
+#include "arena.h"
+
+// Número de blocos do arquivo base por thread, para equilibrar a carga
+// quando o tamanho das linhas varia ao longo do arquivo
+#define LOADER_CHUNKS_PER_THREAD 4
+
+// Tamanho mínimo de cada bloco, em bytes, para que bases pequenas não sejam
+// divididas entre mais threads do que compensa
+#define LOADER_MINCHUNK (256 * 1024)
+
+// Tamanho máximo de uma linha do arquivo base
+#define LOADER_MAXLINE 1024
+
+// Lê o arquivo base filename, cuja primeira linha contém o número de pontos
+// de recarga e as demais os pontos no formato "idend;id_logrado;sigla_tipo;
+// nome_logra;numero_imo;nome_bairr;nome_regio;cep;x;y". O arquivo é dividido
+// em blocos alinhados a quebras de linha, interpretados por nthreads threads
+// diretamente no vetor de pontos de recarga (que é inicializado aqui), na
+// ordem do arquivo. Retorna o número de pontos de recarga, ou -1 se o
+// arquivo não puder ser lido, se alguma linha for inválida ou se o número de
+// pontos não corresponder ao cabeçalho; o erro, com o número da linha, é
+// impresso na saída de erro
+long loader_read_base(const char* filename, int nthreads);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <stdint.h>
+#include "boundary.h"
+
+// Calcula o código de Morton (ordem Z) das coordenadas (x, y), quantizadas em
+// 16 bits por eixo dentro dos limites bd. Pontos próximos no plano tendem a
+// ter códigos próximos, o que permite ordená-los por localidade espacial
+uint32_t morton_encode(Boundary* bd, double x, double y);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef POLYGON_H
+#define POLYGON_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include "boundary.h"
+#include "arena.h"
+
+// Estrutura que representa um polígono simples, dado pelos seus vértices em
+// ordem (o último vértice é ligado ao primeiro)
+typedef struct {
+    char* name;         // Nome do polígono (por exemplo, o bairro ou distrito)
+    long n;             // Número de vértices
+    double* xs;         // Coordenadas x dos vértices
+    double* ys;         // Coordenadas y dos vértices
+    Boundary bb;        // Retângulo envolvente do polígono
+} Polygon;
+
+// Posição de um retângulo em relação a um polígono
+enum { POLY_OUTSIDE = 0, POLY_INSIDE = 1, POLY_PARTIAL = 2 };
+
+// Lê os polígonos do arquivo filename, cujo primeiro valor é o número de
+// polígonos, seguido, para cada polígono, de seu nome (sem espaços), do número
+// de vértices e das coordenadas "x y" de cada vértice. Toda a memória é
+// alocada na arena a. Retorna o vetor de polígonos e armazena sua quantidade
+// em n, ou retorna NULL se o arquivo não puder ser lido
+Polygon* polygon_read(const char* filename, long* n, Arena* a);
+
+// Indica se o ponto (x, y) está dentro do polígono (regra par-ímpar)
+bool polygon_contains(const Polygon* p, double x, double y);
+
+// Classifica o retângulo bd como totalmente dentro, totalmente fora ou
+// parcialmente dentro do polígono p. Um retângulo que nenhuma aresta do
+// polígono atravessa está inteiramente de um dos lados
+int polygon_classify(const Polygon* p, const Boundary* bd);
+
+#endif
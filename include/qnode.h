@@ -4,57 +4,67 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <math.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "boundary.h"
 
-// Estrutura que contém as informações sobre os locais de recarga
-typedef struct {
-    char* idend;        // Identificador do endereco
-    long id_logrado;    // Identificador do logradouro
-    char* sigla_tipo;   // Sigla do tipo de logradouro
-    char* nome_logra;   // Nome do logradouro
-    int numero_imo;     // Número do imóvel
-    char* nome_bairr;   // Nome do bairro
-    char* nome_regio;   // Nome da região
-    int cep;            // Código de Endereçamento Postal (CEP)
-    double x;           // Coordenada x 
-    double y;           // Coordenada y 
-    bool ativo;         // Status de atividade do local de recarga
-} Item;
-
-// Não há ponteiros em uma implementação vetorizada, apenas índices de vetor
-typedef Item nodekey_t;  // Tipo de chave do nó
-typedef long nodeaddr_t; // Tipo de endereço do nó
-
-// Estrutura que representa um nó da QuadTree
+// Não há ponteiros em uma implementação vetorizada, apenas índices de vetor.
+// Índices de 32 bits bastam e reduzem o tamanho de cada nó
+typedef int32_t nodekey_t;  // Tipo de chave do nó (índice do ponto de recarga)
+typedef int32_t nodeaddr_t; // Tipo de endereço do nó
+
+// Estrutura compacta que representa um nó da QuadTree. Os quatro filhos de um
+// nó são sempre criados juntos e ocupam posições consecutivas do vetor (na
+// ordem nw, ne, sw, se), de modo que basta guardar o endereço do primeiro. Os
+// limites de cada nó não são armazenados: são derivados dos limites do pai
+// durante a descida
 typedef struct {
-    Boundary boundary;  // Limites do nó
+    float x;            // Deslocamento x do ponto em relação à origem da QuadTree
+    float y;            // Deslocamento y do ponto em relação à origem da QuadTree
     nodekey_t key;      // Chave do nó
-    nodeaddr_t nw;      // Endereço do quadrante noroeste
-    nodeaddr_t ne;      // Endereço do quadrante nordeste
-    nodeaddr_t sw;      // Endereço do quadrante sudoeste
-    nodeaddr_t se;      // Endereço do quadrante sudeste
+    nodeaddr_t child;   // Endereço do primeiro dos quatro filhos
 } QuadTreeNode;
 
 // Definições de endereços e chaves inválidas
 #define INVALIDADDR -2
-#define INVALIDKEY (nodekey_t) {NULL, 0, NULL, NULL, 0, NULL, NULL, 0, 0, 0}
-#define INVALIDBOUNDARY (Boundary) {0, 0, 0, 0}
+#define INVALIDKEY -1
+
+// No modo paginado, os nós ficam em páginas de NODE_PAGESZ bytes de um 
+// arquivo, e o endereço de um nó é página * NODES_PER_PAGE + posição. As 
+// páginas são lidas por um pool de quadros com substituição LRU
+#define NODE_PAGESZ 4096
+#define NODES_PER_PAGE (NODE_PAGESZ / sizeof(QuadTreeNode))
+
+// Número mínimo de quadros do pool, independente do orçamento de memória
+#define NODE_MINFRAMES 8
 
 // Inicializa o vetor de nós da QuadTree com um número especificado de nós e
 // um limite inicial
 long node_initialize(long numnodes, Boundary qt_boundary);
 
+// Inicializa os nós da QuadTree no modo paginado, com as páginas no arquivo 
+// path (que é truncado) e um pool de até budget bytes
+long node_initialize_paged(const char* path, long numnodes, Boundary qt_boundary, size_t budget);
+
 // Cria um novo nó na QuadTree e retorna seu endereço
 nodeaddr_t node_create(QuadTreeNode* pn);
 
-// Deleta um nó da QuadTree a partir de seu endereço
-void node_delete(nodeaddr_t ad);
+// Cria quatro nós vazios consecutivos e retorna o endereço do primeiro. No 
+// modo paginado, os filhos são criados na página do pai sempre que possível,
+// de modo que as subárvores compartilham páginas
+nodeaddr_t node_create_children(nodeaddr_t parent);
 
 // Recupera um nó da QuadTree a partir de seu endereço
 void node_get(nodeaddr_t ad, QuadTreeNode* pn);
 
+// Antecipa a leitura do nó para a cache, sem bloquear (no modo paginado, as
+// páginas continuam sendo lidas sob demanda)
+void node_prefetch(nodeaddr_t ad);
+
 // Atualiza um nó da QuadTree a partir de seu endereço
 void node_put(nodeaddr_t ad, QuadTreeNode* pn);
 
@@ -70,7 +80,22 @@ void node_reset(QuadTreeNode* pn);
 // Copia os dados de um nó da QuadTree para outro
 void node_copy(QuadTreeNode* dst, QuadTreeNode* src);
 
-// Destroi o vetor de nós da QuadTree, liberando a memória alocada
+// Retorna os limites da QuadTree, cujo canto inferior esquerdo é a origem dos
+// deslocamentos armazenados nos nós
+Boundary node_boundary();
+
+// Indica se os nós estão no modo paginado
+bool node_paged();
+
+// Recupera os contadores acumulados de faltas de página (páginas lidas do 
+// arquivo ou criadas) e de acertos no pool
+void node_page_stats(uint64_t* faults, uint64_t* hits);
+
+// Destroi o vetor de nós da QuadTree (ou o pool e o arquivo de páginas), 
+// liberando a memória alocada
 void node_destroy();
 
-#endif 
\ No newline at end of file
+// Retorna o número de bytes alocados para o vetor de nós (ou para o pool)
+size_t node_memory();
+
+#endif 
@@ -6,7 +6,24 @@
 #include <math.h>
 #include "boundary.h"
 #include "qnode.h"
+#include "station.h"
 #include "heap.h"
+#include "spindex.h"
+#include "polygon.h"
+#include "route.h"
+
+// Configura as próximas quadtrees criadas para o modo paginado, com os nós 
+// no arquivo path e um pool de páginas de até budget bytes (path NULL volta
+// aos nós em memória)
+void quadtree_set_paging(const char* path, size_t budget);
+
+// Modos de divisão dos nós: no ponto médio da célula (padrão) ou, nos modos
+// adaptativos, no ponto armazenado no próprio nó, escolhido na construção 
+// como o ponto mais próximo da mediana ou do centroide dos pontos da célula
+enum { QUADTREE_SPLIT_MIDPOINT = 0, QUADTREE_SPLIT_MEDIAN = 1, QUADTREE_SPLIT_CENTROID = 2 };
+
+// Configura o modo de divisão dos nós das próximas quadtrees
+void quadtree_set_split(int mode);
 
 // Cria uma quadtree com um número especificado de nós e um limite espacial
 void quadtree_create(long numnodes, Boundary boundary);
@@ -14,19 +31,90 @@ void quadtree_create(long numnodes, Boundary boundary);
 // Destroi a quadtree, liberando a memória alocada
 void quadtree_destroy();
 
-// Insere um nó na quadtree com a chave especificada
+// Retorna o número de bytes alocados para a quadtree (nós, resumos e 
+// contadores)
+size_t quadtree_memory();
+
+// Cria uma quadtree com limites bd e a constrói de uma só vez sobre todos os
+// pontos de recarga, escolhendo o ponto de cada nó conforme o modo de divisão
+// adaptativo, o que mantém a árvore rasa mesmo com densidade desigual
+void quadtree_bulk_build(Boundary bd);
+
+// Insere na quadtree o ponto de recarga cujo identificador é a chave k
 void quadtree_insert(nodekey_t k);
 
+// Atualiza os contadores de pontos ativos das subárvores que contêm o ponto
+// de recarga cuja chave é key, que foi ativado ou desativado
+void quadtree_set_active(nodekey_t key, bool ativo);
+
+// Encontra os pontos ativos dentro do polígono, armazena seus identificadores
+// em ids (se não for NULL) e retorna quantos são. Quadrantes inteiramente 
+// fora do polígono são descartados e quadrantes inteiramente dentro são 
+// aceitos sem testes (e, se ids for NULL, contados pelo contador de pontos 
+// ativos do nó); apenas os pontos dos nós que cruzam a borda são testados
+long quadtree_polygon(const Polygon* poly, long* ids);
+
+// Encontra os pontos ativos a até d da rota, armazena seus identificadores e
+// distâncias à rota em result e retorna quantos são. Cada nó recebe os 
+// segmentos da rota que passam a até d da sua célula e os repassa aos 
+// quadrantes, de modo que a árvore é percorrida uma única vez; nós sem 
+// segmentos próximos ou sem pontos ativos são descartados
+long quadtree_corridor(const Route* route, double d, Neighbor* result);
+
+// Encontra os pontos ativos a até d do retângulo r, armazena seus 
+// identificadores em ids e retorna quantos são; nós cuja célula está a mais
+// de d do retângulo ou sem pontos ativos são descartados
+long quadtree_window(const Boundary* r, double d, long* ids);
+
 // Busca um nó na quadtree pelo identificador, a partir das coordenadas (x, y)
 nodeaddr_t quadtree_search(char* idend, double x, double y);
 
-// Encontra os k nós mais próximos das coordenadas (x, y) e armazena os resultados no vetor result
-void quadtree_knn(double x, double y, long k, Neighbor* result);
+// Encontra os k pontos mais próximos das coordenadas (x, y) que satisfazem o
+// filtro, armazena os resultados no vetor result e retorna quantos foram 
+// encontrados. Subárvores cujo resumo de atributos não satisfaz o filtro 
+// são descartadas
+long quadtree_knn(double x, double y, long k, const Filter* filter, Neighbor* result);
+
+// Número de consultas mantidas em andamento ao mesmo tempo por 
+// quadtree_knn_batch
+#define QUADTREE_INFLIGHT 8
+
+// Encontra os ks[i] pontos ativos mais próximos de cada uma das nq consultas
+// (xs[i], ys[i]), cujos vizinhos ficam em result[i], em ordem de distância, e
+// sua quantidade em found[i]. Até QUADTREE_INFLIGHT consultas ficam em 
+// andamento: quando uma delas precisa de um nó, a leitura do nó é antecipada
+// e a consulta seguinte prossegue, de modo que os acessos à memória de várias
+// consultas se sobrepõem. Os resultados são os mesmos de quadtree_knn
+void quadtree_knn_batch(const double* xs, const double* ys, const long* ks, long nq, Neighbor** result, long* found);
+
+// Encontra os k pontos ativos mais próximos de cada uma das nq consultas 
+// (xs[i], ys[i]), que devem estar em ordem espacial, por uma travessia dupla
+// entre uma árvore sobre as consultas e a quadtree. Os vizinhos da consulta i
+// ficam em result[i * k], em ordem de distância, e sua quantidade em found[i]
+void quadtree_knn_join(const double* xs, const double* ys, long nq, long k, Neighbor* result, long* found);
+
+// Cursor que percorre os pontos da quadtree em ordem crescente de distância
+typedef struct QuadTreeCursor QuadTreeCursor;
+
+// Abre um cursor sobre os pontos que satisfazem o filtro (NULL para nenhum),
+// em ordem crescente de distância das coordenadas (x, y)
+QuadTreeCursor* quadtree_cursor_open(double x, double y, const Filter* filter);
+
+// Armazena em result os próximos k pontos ativos do cursor e retorna quantos
+// foram encontrados. A fronteira da busca é mantida entre as chamadas, de 
+// modo que cada página custa apenas o trabalho incremental
+long quadtree_cursor_next(QuadTreeCursor* c, long k, Neighbor* result);
+
+// Fecha o cursor, liberando a memória alocada
+void quadtree_cursor_close(QuadTreeCursor* c);
 
 // Exporta a estrutura da quadtree para um arquivo
 void export_quadtree(const char* filename);
 
-// Exporta um nó específico da quadtree para um arquivo
-void export_node(nodeaddr_t addr, FILE* file);
+// Exporta um nó específico da quadtree, cujos limites são bd, para um arquivo
+void export_node(nodeaddr_t addr, Boundary bd, FILE* file);
+
+// A quadtree como motor de índice espacial
+extern const SpatialIndex quadtree_index;
 
 #endif
\ No newline at end of file
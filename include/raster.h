@@ -0,0 +1,50 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "boundary.h"
+#include "station.h"
+#include "spindex.h"
+
+// Número máximo de células em cada dimensão do mapa
+#define RASTER_MAXSIDE 16384
+
+// Número de candidatos a partir do qual uma região deixa de ser dividida e
+// cada célula compara todos os candidatos
+#define RASTER_LEAF 4
+
+// Número máximo de células de uma região resolvida por uma única thread; as
+// regiões maiores são divididas antes da distribuição entre as threads
+#define RASTER_TASKCELLS (64 * 64)
+
+// Lado, em células, dos blocos cujos pontos ativos mais próximos limitam o 
+// raio da consulta que semeia os candidatos de cada região
+#define RASTER_SEEDSIDE 32
+
+// Identificação do formato do arquivo do mapa
+#define RASTER_MAGIC "BIUH"
+
+// Calcula, para cada célula de um mapa de nx x ny células sobre os limites 
+// bd, a distância do centro da célula ao ponto de recarga ativo mais próximo
+// (infinita se não houver nenhum) e o número de pontos ativos na célula. O 
+// mapa é dividido recursivamente em quadrantes, como uma quadtree: cada 
+// região recebe os candidatos da região mãe e descarta aqueles que não podem
+// ser o mais próximo de nenhuma de suas células, de modo que células vizinhas
+// compartilham o trabalho. Se o motor ix oferecer consultas por janela, os 
+// candidatos de cada região distribuída entre as threads são obtidos dele, 
+// a até o raio herdado da região mãe, sem percorrer todos os pontos ativos.
+// As regiões são distribuídas entre nthreads threads. O resultado é gravado
+// no arquivo binário filename: a identificação RASTER_MAGIC, nx e ny (int32_t), os limites x_min, y_min, x_max e y_max 
+// (double), as distâncias (float) e os números de pontos ativos (int32_t), 
+// linha a linha a partir de y_min. Retorna a maior distância finita, ou -1 
+// em caso de erro
+double raster_write(const SpatialIndex* ix, const char* filename, long nx, long ny, Boundary bd, int nthreads);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include "boundary.h"
+
+// Estrutura que representa uma rota, dada pelos seus vértices em ordem; os
+// segmentos ligam cada vértice ao seguinte. Uma rota de um único vértice 
+// tem um único segmento degenerado, o próprio vértice
+typedef struct {
+    long n;             // Número de vértices
+    const double* xs;   // Coordenadas x dos vértices
+    const double* ys;   // Coordenadas y dos vértices
+} Route;
+
+// Retorna o número de segmentos da rota
+long route_segments(const Route* r);
+
+// Calcula a distância do ponto (x, y) ao segmento s da rota
+double route_segment_dist(const Route* r, long s, double x, double y);
+
+// Calcula a distância do retângulo bd ao segmento s da rota, zero se o 
+// segmento tocar o retângulo
+double route_segment_rect_dist(const Route* r, long s, const Boundary* bd);
+
+// Calcula a distância do ponto (x, y) à rota, isto é, ao segmento mais 
+// próximo
+double route_dist(const Route* r, double x, double y);
+
+// Retorna o índice do vértice da rota mais próximo do ponto (x, y)
+long route_nearest_vertex(const Route* r, double x, double y);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "boundary.h"
+#include "station.h"
+#include "heap.h"
+#include "spindex.h"
+
+// Número de coordenadas processadas por instrução vetorial
+#define SCAN_LANES 4
+
+// Número de pontos cujas distâncias são calculadas de uma vez, antes da
+// seleção dos candidatos
+#define SCAN_BLOCK 256
+
+// Vetor de SCAN_LANES coordenadas, operado com instruções SIMD por meio das
+// extensões vetoriais do compilador
+typedef double ScanVec __attribute__((vector_size(SCAN_LANES * sizeof(double))));
+
+// Copia as coordenadas dos pontos de recarga para vetores compactos x e y,
+// alinhados e completados até um múltiplo de SCAN_LANES. Pode ser chamada
+// novamente para reconstruir os vetores
+void scan_build(Boundary bd);
+
+// Destroi os vetores de coordenadas, liberando a memória alocada
+void scan_destroy();
+
+// Retorna o número de bytes alocados para os vetores de coordenadas
+size_t scan_memory();
+
+// Busca um ponto de recarga pelo identificador entre os pontos com as
+// coordenadas (x, y) e retorna seu índice ou INVALIDSTATION
+long scan_search(char* idend, double x, double y);
+
+// Encontra os k pontos mais próximos das coordenadas (x, y) que satisfazem o
+// filtro, percorrendo todos os pontos: as distâncias de cada bloco são
+// calculadas com instruções vetoriais e apenas os pontos mais próximos que o
+// k-ésimo vizinho atual são verificados e inseridos no heap. Armazena os
+// resultados no vetor result e retorna quantos foram encontrados
+long scan_knn(double x, double y, long k, const Filter* filter, Neighbor* result);
+
+// A varredura linear como motor de índice espacial
+extern const SpatialIndex scan_index;
+
+#endif
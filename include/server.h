@@ -0,0 +1,28 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h>
+
+// Função que executa um comando (uma linha, sem o caractere de nova linha) e
+// escreve a resposta em out
+typedef void (*command_handler)(char* line, FILE* out);
+
+// Função que torna duráveis os efeitos dos comandos já executados. É chamada
+// uma vez por rodada de eventos, antes de as respostas serem enviadas, de 
+// modo que vários comandos são confirmados juntos, e também quando a espera
+// por eventos é interrompida por um sinal
+typedef void (*commit_handler)();
+
+// Atende comandos recebidos em um socket Unix no caminho path, usando E/S não
+// bloqueante orientada a eventos (epoll). Cada conexão pode enviar várias 
+// requisições em sequência, sem esperar as respostas; as respostas são 
+// devolvidas na mesma ordem, cada uma terminada por uma linha vazia. commit
+// pode ser NULL. Retorna 0 quando o servidor é encerrado por SIGINT ou 
+// SIGTERM, ou -1 em caso de erro
+int server_run_socket(const char* path, command_handler handler, commit_handler commit);
+
+// Atende comandos lidos da entrada padrão, escrevendo as respostas na saída 
+// padrão no mesmo formato do socket. Retorna 0 ao fim da entrada
+int server_run_stdio(command_handler handler, commit_handler commit);
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef SPINDEX_H
+#define SPINDEX_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "boundary.h"
+#include "station.h"
+#include "heap.h"
+#include "filter.h"
+#include "polygon.h"
+#include "route.h"
+
+// Interface comum dos índices espaciais (motores) sobre o vetor de pontos de
+// recarga. Todos os motores identificam os pontos pelo seu índice no vetor de
+// pontos de recarga e devolvem vizinhos com esse identificador
+typedef struct {
+    const char* name;   // Nome do motor, usado na linha de comando
+
+    // Constrói o índice sobre todos os pontos de recarga do vetor, dentro dos
+    // limites bd
+    void (*build)(Boundary bd);
+
+    // Destroi o índice, liberando a memória alocada
+    void (*destroy)();
+
+    // Notifica o índice de que o ponto de recarga id foi ativado ou
+    // desativado, logo após a alteração e apenas se o status mudou
+    // (pode ser NULL se o motor não mantém estado próprio)
+    void (*set_active)(long id, bool ativo);
+
+    // Busca o ponto de recarga pelo identificador, a partir das coordenadas
+    // (x, y), e retorna seu índice ou INVALIDSTATION
+    long (*search)(char* idend, double x, double y);
+
+    // Encontra os k pontos de recarga ativos mais próximos de (x, y) que
+    // satisfazem o filtro (NULL para nenhum), armazena os resultados, em 
+    // ordem de distância, no vetor result e retorna quantos foram encontrados
+    long (*knn)(double x, double y, long k, const Filter* filter, Neighbor* result);
+
+    // Encontra os k pontos de recarga ativos mais próximos de cada uma das nq
+    // consultas (xs[i], ys[i]), dadas em ordem espacial, de uma só vez; os 
+    // vizinhos da consulta i ficam em result[i * k] e sua quantidade em 
+    // found[i] (pode ser NULL se o motor não oferece junção)
+    void (*knn_join)(const double* xs, const double* ys, long nq, long k, Neighbor* result, long* found);
+
+    // Encontra os ks[i] pontos de recarga ativos mais próximos de cada uma
+    // das nq consultas (xs[i], ys[i]), intercalando as consultas para 
+    // sobrepor seus acessos à memória; os vizinhos da consulta i ficam em
+    // result[i] e sua quantidade em found[i] (pode ser NULL se o motor não
+    // oferece consultas intercaladas)
+    void (*knn_batch)(const double* xs, const double* ys, const long* ks, long nq, Neighbor** result, long* found);
+
+    // Abre um cursor que percorre os pontos de recarga ativos que satisfazem
+    // o filtro em ordem crescente de distância a (x, y); as funções de 
+    // cursor podem ser NULL se o motor não oferece cursores
+    void* (*cursor_open)(double x, double y, const Filter* filter);
+
+    // Armazena em result os próximos k pontos do cursor e retorna quantos
+    // foram encontrados (menos que k quando o cursor se esgota)
+    long (*cursor_next)(void* cursor, long k, Neighbor* result);
+
+    // Fecha o cursor, liberando a memória alocada
+    void (*cursor_close)(void* cursor);
+
+    // Encontra os pontos de recarga ativos dentro do polígono, armazena seus
+    // identificadores em ids (se não for NULL) e retorna quantos são (pode 
+    // ser NULL se o motor não oferece consultas por polígono)
+    long (*polygon)(const Polygon* poly, long* ids);
+
+    // Encontra os pontos de recarga ativos a até d da rota, armazena seus 
+    // identificadores e distâncias à rota em result, em qualquer ordem, e
+    // retorna quantos são (pode ser NULL se o motor não oferece consultas 
+    // por corredor)
+    long (*corridor)(const Route* route, double d, Neighbor* result);
+
+    // Encontra os pontos de recarga ativos a até d do retângulo r (os pontos
+    // dentro dele estão a distância zero), armazena seus identificadores em
+    // ids, em qualquer ordem, e retorna quantos são (pode ser NULL se o motor
+    // não oferece consultas por janela)
+    long (*window)(const Boundary* r, double d, long* ids);
+
+    // Retorna o número de bytes alocados para o índice
+    size_t (*memory)();
+} SpatialIndex;
+
+// Retorna o motor com o nome especificado, ou NULL se não existir
+const SpatialIndex* spindex_find(const char* name);
+
+// Imprime os nomes dos motores disponíveis
+void spindex_list(FILE* out);
+
+// Ativa ou desativa o ponto de recarga id e notifica o motor; a pirâmide de
+// tiles também é atualizada
+void spindex_set_active(const SpatialIndex* ix, long id, bool ativo);
+
+// Altera para ativo os pontos de recarga de ids que ainda não estão nesse 
+// status e notifica o motor (e a pirâmide de tiles); os alterados são 
+// armazenados em changed e a função retorna quantos foram
+long spindex_set_active_list(const SpatialIndex* ix, const long* ids, long n, bool ativo, long* changed);
+
+// Encontra os k pontos de recarga ativos mais próximos de (x, y) que 
+// satisfazem o filtro usando o motor; retorna quantos foram encontrados
+long spindex_knn(const SpatialIndex* ix, double x, double y, long k, const Filter* filter, Neighbor* result);
+
+// Executa as nq consultas (xs[i], ys[i], ks[i]) de uma vez, de forma 
+// intercalada se o motor oferecer; os vizinhos da consulta i ficam em 
+// result[i] e sua quantidade em found[i]
+void spindex_knn_batch(const SpatialIndex* ix, const double* xs, const double* ys, const long* ks, long nq,
+                       Neighbor** result, long* found);
+
+// Encontra os pontos de recarga ativos dentro do polígono usando o motor (ou
+// uma varredura dos pontos ativos, se o motor não oferecer). Os 
+// identificadores são armazenados em ids, em ordem crescente, se ids não for
+// NULL; retorna quantos são
+long spindex_polygon(const SpatialIndex* ix, const Polygon* poly, long* ids);
+
+// Encontra os pontos de recarga ativos a até d da rota (corredor) usando o
+// motor (ou uma varredura dos pontos ativos, se o motor não oferecer). Cada
+// ponto aparece uma única vez, com sua distância à rota; os pontos são 
+// armazenados em result em ordem crescente de distância e a função retorna
+// quantos são
+long spindex_corridor(const SpatialIndex* ix, const Route* route, double d, Neighbor* result);
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef STATION_H
+#define STATION_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "arena.h"
+#include "boundary.h"
+
+// Estrutura que contém as informações sobre os locais de recarga
+typedef struct {
+    char* idend;        // Identificador do endereco
+    long id_logrado;    // Identificador do logradouro
+    char* sigla_tipo;   // Sigla do tipo de logradouro
+    char* nome_logra;   // Nome do logradouro
+    int numero_imo;     // Número do imóvel
+    char* nome_bairr;   // Nome do bairro
+    char* nome_regio;   // Nome da região
+    int cep;            // Código de Endereçamento Postal (CEP)
+    double x;           // Coordenada x 
+    double y;           // Coordenada y 
+} Item;
+
+// Os pontos de recarga ficam em um vetor próprio, fora dos nós da QuadTree,
+// e são identificados pela sua posição nesse vetor
+#define INVALIDSTATION -1
+
+// Inicializa o vetor de pontos de recarga com capacidade para numstations
+long station_initialize(long numstations);
+
+// Adiciona uma cópia do ponto de recarga ao vetor e retorna seu identificador
+long station_add(Item* it);
+
+// Reserva n posições consecutivas no vetor, com os pontos de recarga ativos,
+// e retorna o identificador da primeira; os Items devem ser preenchidos por
+// meio de station_get antes de qualquer consulta
+long station_add_block(long n);
+
+// Recupera o ponto de recarga a partir de seu identificador
+Item* station_get(long id);
+
+// Retorna o número de pontos de recarga armazenados
+long station_count();
+
+// Retorna o menor retângulo que contém todos os pontos de recarga, com os 
+// limites superiores ajustados para que os pontos extremos fiquem dentro do
+// retângulo semiaberto
+Boundary station_boundary();
+
+// Copia a string s para a arena dos pontos de recarga, que é liberada de uma
+// só vez em station_destroy
+char* station_strdup(const char* s);
+
+// Transfere as strings da arena a, preenchida fora do módulo (por exemplo, 
+// por outra thread), para a arena dos pontos de recarga
+void station_adopt_strings(Arena* a);
+
+// Destroi o vetor de pontos de recarga e a arena de strings, liberando a 
+// memória alocada
+void station_destroy();
+
+// Retornam o número de bytes alocados para o vetor de pontos de recarga e o
+// vetor de bits de atividade, para as strings e para o índice por bairro
+size_t station_memory();
+size_t station_strings_memory();
+size_t station_cache_memory();
+
+// O status de atividade fica em um vetor de bits denso, indexado pelo 
+// identificador do ponto de recarga, fora do Item. Ele é lido sem bloqueio 
+// pelas consultas e alterado de forma atômica por um único escritor (a 
+// thread que processa os comandos), fora das consultas, de modo que cada
+// consulta observa um estado fixo. Os pontos de recarga são adicionados ativos
+
+// Indica se o ponto de recarga id está ativo
+bool station_is_active(long id);
+
+// Função chamada para cada ponto de recarga cujo status foi alterado, logo
+// após a alteração, de modo que dados derivados do status (por exemplo,
+// contadores de um índice) acompanham o status
+typedef void (*station_notify)(long id, bool ativo);
+
+// Ativa ou desativa o ponto de recarga id e chama notify (se não for NULL)
+// caso o status tenha mudado; retorna se mudou
+bool station_set_active(long id, bool ativo, station_notify notify);
+
+// Altera para ativo os pontos de recarga de ids (n identificadores) que 
+// ainda não estão nesse status, chamando notify para cada um; os 
+// identificadores alterados são armazenados em changed e a função retorna 
+// quantos foram
+long station_set_active_list(const long* ids, long n, bool ativo, long* changed, station_notify notify);
+
+// Retorna o número de pontos de recarga ativos
+long station_count_active();
+
+// Retorna o primeiro ponto de recarga a partir de from cujo status é ativo,
+// ou INVALIDSTATION se não houver
+long station_next(long from, bool ativo);
+
+// Retorna os identificadores dos pontos de recarga do bairro especificado,
+// em ordem crescente, e armazena sua quantidade em n
+const long* station_bairro(const char* bairro, long* n);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "boundary.h"
+#include "station.h"
+
+// Nível de zoom mais detalhado da pirâmide, em que a área da cidade é 
+// dividida em 2^TILES_MAXZOOM x 2^TILES_MAXZOOM tiles
+#define TILES_MAXZOOM 8
+
+// A pirâmide de tiles divide o quadrado que contém os limites da base em 
+// 2^z x 2^z tiles no nível z; cada tile do nível z é a união de quatro tiles
+// do nível z + 1, como os quadrantes de um nó da quadtree. Cada tile guarda 
+// o número de pontos de recarga e de pontos ativos da sua área, de modo que 
+// o mapa é gerado a partir dos contadores, sem percorrer os pontos
+
+// Constrói a pirâmide sobre os limites bd, contando os pontos de recarga do
+// vetor no nível mais detalhado e somando os níveis superiores a partir dele
+void tiles_build(Boundary bd);
+
+// Destroi a pirâmide, liberando a memória alocada
+void tiles_destroy();
+
+// Atualiza os contadores dos tiles que contêm o ponto de recarga id, cujo 
+// status mudou para ativo (ou inativo), em todos os níveis
+void tiles_set_active(long id, bool ativo);
+
+// Retorna o número de bytes alocados para a pirâmide
+size_t tiles_memory();
+
+// Escreve em out os tiles não vazios do nível zoom que interceptam o 
+// retângulo view (NULL para todos), um por linha no formato "i j x_min y_min
+// x_max y_max ativos inativos", em que i é a coluna e j a linha do tile. 
+// Retorna quantos tiles foram escritos, ou -1 se o nível for inválido
+long tiles_write(FILE* out, int zoom, const Boundary* view);
+
+#endif
@@ -0,0 +1,72 @@
+#include "arena.h"
+
+// Função auxiliar que aloca size bytes da arena com o alinhamento align
+static void* arena_alloc_aligned(Arena* a, size_t size, size_t align) {
+    // Posição da alocação no bloco atual, respeitando o alinhamento
+    size_t offset = a->head != NULL ? (a->head->used + align - 1) / align * align : 0;
+
+    // Aloca um novo bloco se o atual não comporta a alocação; alocações 
+    // maiores que o bloco padrão recebem um bloco próprio
+    if (a->head == NULL || offset + size > a->head->size) {
+        size_t blocksz = size > ARENA_BLOCKSZ ? size : ARENA_BLOCKSZ;
+        ArenaBlock* b = (ArenaBlock*) malloc(sizeof(ArenaBlock) + blocksz);
+        if (b == NULL) {
+            fprintf(stderr,"arena_alloc: could not allocate block\n");
+            return NULL;
+        }
+        b->prev = a->head;
+        b->size = blocksz;
+        b->used = 0;
+        a->head = b;
+        a->reserved += sizeof(ArenaBlock) + blocksz;
+        offset = 0;
+    }
+    void* p = (char*) a->head->data + offset;
+    a->head->used = offset + size;
+    a->used += size;
+    return p;
+}
+
+void* arena_alloc(Arena* a, size_t size) {
+    return arena_alloc_aligned(a, size, sizeof(max_align_t));
+}
+
+char* arena_strdup(Arena* a, const char* s) {
+    // Strings não precisam de alinhamento
+    size_t len = strlen(s) + 1;
+    char* p = (char*) arena_alloc_aligned(a, len, 1);
+    if (p != NULL) memcpy(p, s, len);
+    return p;
+}
+
+void arena_merge(Arena* dst, Arena* src) {
+    if (src->head == NULL) return;
+    // Os blocos de src são encadeados abaixo do bloco atual de dst, que 
+    // continua recebendo as próximas alocações
+    ArenaBlock* oldest = src->head;
+    while (oldest->prev != NULL) oldest = oldest->prev;
+    if (dst->head == NULL) {
+        dst->head = src->head;
+    }
+    else {
+        oldest->prev = dst->head->prev;
+        dst->head->prev = src->head;
+    }
+    dst->used += src->used;
+    dst->reserved += src->reserved;
+    *src = EMPTYARENA;
+}
+
+void arena_release(Arena* a) {
+    while (a->head != NULL) {
+        ArenaBlock* prev = a->head->prev;
+        free(a->head);
+        a->head = prev;
+    }
+    a->used = 0;
+    a->reserved = 0;
+}
+
+size_t arena_memory(const Arena* a) {
+    return a->reserved;
+}
@@ -0,0 +1,149 @@
+#include "autoindex.h"
+
+// Número de bases medidas
+#define AUTOINDEX_NSIZES 4
+
+// Número de pontos das bases medidas e número de vizinhos em que a 
+// varredura alcança a quadtree em cada uma (tempos por consulta de knnbench,
+// interpolados entre as potências de 2 vizinhas). Entre 2 mil e 200 mil 
+// pontos, k cresce aproximadamente com n^0,35; de 200 mil a 2 milhões, com
+// n^0,6, pois a quadtree passa a sofrer mais faltas na cache
+static const double autoindex_sizes[AUTOINDEX_NSIZES] = {2000, 20000, 200000, 2000000};
+static const double autoindex_ks[AUTOINDEX_NSIZES] = {2.0, 4.4, 10.2, 40};
+
+double autoindex_crossover(long n) {
+    if (n < 1) n = 1;
+    // Escolhe o par de medições que cerca n, ou o par mais próximo se n 
+    // estiver fora delas, e interpola log k linearmente em log n
+    int i = 0;
+    while (i < AUTOINDEX_NSIZES - 2 && n > autoindex_sizes[i + 1]) i++;
+    double t = log(n / autoindex_sizes[i]) / log(autoindex_sizes[i + 1] / autoindex_sizes[i]);
+    return autoindex_ks[i] * pow(autoindex_ks[i + 1] / autoindex_ks[i], t);
+}
+
+bool autoindex_use_scan(long k) {
+    return k >= autoindex_crossover(station_count());
+}
+
+static void autoindex_build(Boundary bd) {
+    quadtree_index.build(bd);
+    scan_build(bd);
+}
+
+static void autoindex_destroy() {
+    quadtree_index.destroy();
+    scan_destroy();
+}
+
+static size_t autoindex_memory() {
+    return quadtree_index.memory() + scan_memory();
+}
+
+// As operações que não dependem do número de vizinhos usam a quadtree
+static void autoindex_set_active(long id, bool ativo) {
+    quadtree_index.set_active(id, ativo);
+}
+
+static long autoindex_search(char* idend, double x, double y) {
+    return quadtree_index.search(idend, x, y);
+}
+
+static void* autoindex_cursor_open(double x, double y, const Filter* filter) {
+    return quadtree_index.cursor_open(x, y, filter);
+}
+
+static long autoindex_cursor_next(void* cursor, long k, Neighbor* result) {
+    return quadtree_index.cursor_next(cursor, k, result);
+}
+
+static void autoindex_cursor_close(void* cursor) {
+    quadtree_index.cursor_close(cursor);
+}
+
+static long autoindex_polygon(const Polygon* poly, long* ids) {
+    return quadtree_index.polygon(poly, ids);
+}
+
+static long autoindex_corridor(const Route* route, double d, Neighbor* result) {
+    return quadtree_index.corridor(route, d, result);
+}
+
+static long autoindex_window(const Boundary* r, double d, long* ids) {
+    return quadtree_index.window(r, d, ids);
+}
+
+static long autoindex_knn(double x, double y, long k, const Filter* filter, Neighbor* result) {
+    if (autoindex_use_scan(k)) return scan_knn(x, y, k, filter, result);
+    return quadtree_index.knn(x, y, k, filter, result);
+}
+
+static void autoindex_knn_join(const double* xs, const double* ys, long nq, long k, Neighbor* result, long* found) {
+    // Todas as consultas da junção têm o mesmo k, de modo que a escolha vale
+    // para o bloco inteiro
+    if (!autoindex_use_scan(k)) {
+        quadtree_index.knn_join(xs, ys, nq, k, result, found);
+        return;
+    }
+    for (long i = 0; i < nq; i++) {
+        found[i] = scan_knn(xs[i], ys[i], k, NULL, result + i * k);
+    }
+}
+
+static void autoindex_knn_batch(const double* xs, const double* ys, const long* ks, long nq, Neighbor** result, long* found) {
+    // As consultas resolvidas pela quadtree são agrupadas, na mesma ordem, 
+    // para que continuem intercaladas; as demais usam a varredura
+    double* qxs = (double*) malloc((nq + 1) * sizeof(double));
+    double* qys = (double*) malloc((nq + 1) * sizeof(double));
+    long* qks = (long*) malloc((nq + 1) * sizeof(long));
+    long* qfound = (long*) malloc((nq + 1) * sizeof(long));
+    long* qpos = (long*) malloc((nq + 1) * sizeof(long));
+    Neighbor** qresult = (Neighbor**) malloc((nq + 1) * sizeof(Neighbor*));
+    if (qxs == NULL || qys == NULL || qks == NULL || qfound == NULL || qpos == NULL || qresult == NULL) {
+        fprintf(stderr,"autoindex_knn_batch: could not allocate batch\n");
+        for (long i = 0; i < nq; i++) {
+            found[i] = autoindex_knn(xs[i], ys[i], ks[i], NULL, result[i]);
+        }
+    }
+    else {
+        long m = 0;
+        for (long i = 0; i < nq; i++) {
+            if (autoindex_use_scan(ks[i])) {
+                found[i] = scan_knn(xs[i], ys[i], ks[i], NULL, result[i]);
+                continue;
+            }
+            qxs[m] = xs[i];
+            qys[m] = ys[i];
+            qks[m] = ks[i];
+            qresult[m] = result[i];
+            qpos[m++] = i;
+        }
+        if (m > 0) quadtree_index.knn_batch(qxs, qys, qks, m, qresult, qfound);
+        for (long j = 0; j < m; j++) {
+            found[qpos[j]] = qfound[j];
+        }
+    }
+    free(qxs);
+    free(qys);
+    free(qks);
+    free(qfound);
+    free(qpos);
+    free(qresult);
+}
+
+const SpatialIndex auto_index = {
+    "auto",
+    autoindex_build,
+    autoindex_destroy,
+    autoindex_set_active,
+    autoindex_search,
+    autoindex_knn,
+    autoindex_knn_join,
+    autoindex_knn_batch,
+    autoindex_cursor_open,
+    autoindex_cursor_next,
+    autoindex_cursor_close,
+    autoindex_polygon,
+    autoindex_corridor,
+    autoindex_window,
+    autoindex_memory
+};
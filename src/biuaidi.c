@@ -7,16 +7,105 @@
 //	  2.0 - 15/08/2024	
 //
 // Uso: 
-// biuaidi
+// biuaidi -b <arquivo_base> -e <arquivo_ev> [-p <threads>] [-i <motor> [-a <divisao>]] [-d <paginas> [-c <KiB>]] [-z] [-v] [-j <diario>] [-t <arquivo>]
+// biuaidi -b <arquivo_base> -s <socket> [-p <threads>] [-i <motor> [-a <divisao>]] [-d <paginas> [-c <KiB>]] [-v] [-j <diario>] [-t <arquivo>]
+// biuaidi -b <arquivo_base> -q <arquivo_pontos> [-k <n>] [-p <threads>] [-i <motor> [-a <divisao>]] [-d <paginas> [-c <KiB>]] [-v] [-j <diario>]
 // 
-// O programa lê os pontos de recarga a partir do arquivo "geracarga.base" 
-// e os comandos a partir do arquivo "geracarga.ev".
+// O programa lê os pontos de recarga a partir do arquivo base (por exemplo, 
+// "geracarga.base") e os comandos a partir do arquivo de eventos (por 
+// exemplo, "geracarga.ev"). A opção -i seleciona o índice espacial usado nas
+// consultas: "quadtree" (padrão), "kdtree", "grid", "scan" (varredura linear
+// vetorizada de todos os pontos) ou "auto", que escolhe entre a varredura e a
+// quadtree a cada consulta, conforme o número de pontos da base e o número 
+// de vizinhos pedidos; seus limites são calculados a partir dos pontos da 
+// base. Na quadtree (também no motor "auto"), a opção -a seleciona a divisão
+// dos nós: "meio" (padrão), no ponto médio de cada célula, ou "mediana" e 
+// "centroide", em que a árvore é construída de uma só vez e cada nó divide
+// sua célula no ponto mais próximo da mediana ou do centroide dos pontos da
+// célula, o que a mantém rasa quando a densidade é desigual. 
+//
+// Com a opção -z, cada sequência de comandos C entre eventos A/D é executada
+// em lote, na ordem do código de Morton das coordenadas, com várias consultas
+// em andamento ao mesmo tempo para sobrepor seus acessos à memória, e os 
+// resultados são impressos na ordem original.
+//
+// O arquivo base é dividido em blocos lidos em paralelo por <threads> 
+// threads (opção -p; por padrão, uma por processador); uma linha inválida, 
+// ou um número de pontos diferente do indicado na primeira linha, encerra o
+// programa com a indicação da linha.
+//
+// Com a opção -s, o programa carrega o índice uma única vez e passa a atender 
+// os comandos abaixo, um por linha, no socket Unix <socket> (ou na entrada e
+// saída padrão, se <socket> for "-"). A resposta de cada comando termina com
+// uma linha vazia; várias requisições podem ser enviadas em sequência em uma
+// mesma conexão. Nesse modo o mapa ilustrativo não é gerado.
+//
+// Com a opção -q, o programa encontra os <n> pontos de recarga mais próximos
+// (opção -k, 1 por padrão) de cada ponto do arquivo <arquivo_pontos>, cuja 
+// primeira linha contém o número de pontos e as demais as coordenadas "x y".
+// Os pontos são resolvidos em conjunto, por uma travessia dupla entre os 
+// pontos ordenados espacialmente e o índice, dividida entre as <threads> 
+// threads. A saída tem o mesmo formato do comando C.
+//
+// Com a opção -d, os nós da quadtree ficam em páginas do arquivo <paginas>,
+// lidas por um pool com substituição LRU limitado a <KiB> KiB (opção -c, 
+// 1024 por padrão), de modo que o índice pode exceder a memória disponível.
+// O relatório de latência passa a incluir as faltas de página por comando e
+// a taxa de acertos no pool.
+//
+// Com a opção -v, o resultado de cada consulta C e F (e das consultas da
+// opção -q) é comparado ao da varredura linear; as divergências e, ao final,
+// o total de consultas comparadas são impressos na saída de erro.
+//
+// Com a opção -j, cada ativação ou desativação é registrada no diário 
+// <diario>, gravado em grupos. Na inicialização, o último snapshot 
+// (<diario>.snap) e os eventos do diário são reaplicados sobre a base, de
+// modo que o estado dos pontos de recarga sobrevive a reinícios.
+//
+// A latência de cada comando A, D e C (este separado por faixa de n) é medida
+// nas fases de leitura, busca e saída. Os percentis são escritos em JSON no 
+// arquivo indicado por -t ao final da execução e sempre que o programa 
+// recebe SIGUSR1 (na saída de erro, se -t não for usado).
 // 
 // Comandos no arquivo "geracarga.ev":
 //    A <id> - Ativar ponto de recarga com o identificador <id>
 //    D <id> - Desativar ponto de recarga com o identificador <id>
 //    C <x> <y> <n> - Encontrar os <n> pontos de recarga mais próximos das 
 //    coordenadas <x> e <y>
+//    F <x> <y> <n> <campo> <valor> - Encontrar os <n> pontos de recarga mais 
+//    próximos das coordenadas <x> e <y> cujo <campo> ("regiao", "bairro" ou
+//    "tipo") é igual a <valor>, ou cujo CEP começa por <valor> ("cep")
+//    P <x> <y> <n> - Iniciar uma consulta paginada a partir das coordenadas 
+//    <x> e <y>, imprimindo os <n> pontos de recarga mais próximos
+//    M <n> - Imprimir os próximos <n> pontos de recarga da consulta paginada
+//    B A <bairro> - Ativar todos os pontos de recarga do bairro <bairro>
+//    B D <bairro> - Desativar todos os pontos de recarga do bairro <bairro>
+//    S - Contar os pontos de recarga ativos
+//    G <arquivo> - Listar os pontos de recarga ativos dentro de cada polígono
+//    do arquivo <arquivo>, cujo primeiro valor é o número de polígonos, 
+//    seguido, para cada polígono, do nome, do número de vértices e das 
+//    coordenadas "x y" dos vértices
+//    K <arquivo> - Contar os pontos de recarga ativos dentro de cada polígono
+//    do arquivo <arquivo>
+//    T <z> [<x_min> <y_min> <x_max> <y_max>] - Imprimir os tiles não vazios
+//    do nível <z> (de 0 a 8) da pirâmide de tiles, que divide a área da base
+//    em 2^z x 2^z quadrados, apenas os que interceptam o retângulo, se 
+//    indicado; cada linha contém a coluna, a linha, os limites e os números
+//    de pontos de recarga ativos e inativos do tile. Os contadores são 
+//    atualizados a cada ativação ou desativação, sem percorrer os pontos
+//    H <nx> <ny> <arquivo> - Gravar no arquivo binário <arquivo> o mapa de 
+//    <nx> x <ny> células sobre a área da base com a distância do centro de 
+//    cada célula ao ponto de recarga ativo mais próximo e o número de pontos
+//    ativos da célula, calculado em conjunto para todas as células pelas 
+//    <threads> threads (veja raster.h para o formato)
+//    Q <d> <x1> <y1> <x2> <y2> ... - Encontrar os pontos de recarga ativos a
+//    até <d> da rota formada pelos vértices (<x1>, <y1>), (<x2>, <y2>), ..., 
+//    com uma única travessia do índice, em ordem de distância à rota; cada 
+//    ponto aparece uma única vez, com sua distância à rota e o número do 
+//    vértice da rota mais próximo (a partir de 1)
+//    U - Imprimir a memória alocada, em bytes, por parte do programa
+//    R - Recarregar a base, liberando todos os dados carregados, e reaplicar
+//    o diário
 // 
 // Saída:
 //    Resultados dos comandos executados, incluindo a ativação/desativação de 
@@ -28,26 +117,73 @@
 #include <math.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include "quadtree.h"
 #include "qnode.h"
+#include "station.h"
 #include "heap.h"
 #include "boundary.h"
+#include "spindex.h"
+#include "filter.h"
+#include "join.h"
+#include "loader.h"
+#include "scan.h"
+#include "autoindex.h"
+#include "polygon.h"
+#include "tiles.h"
+#include "raster.h"
+#include "morton.h"
+#include "server.h"
+#include "journal.h"
+#include "latency.h"
 
 // Variável global para armazenar o número de pontos de recarga
 int nrecharge = 0;
 
+// Número de threads usadas na leitura da base e na junção (opção -p)
+int nthreads = 1;
+
+// Arquivo base e diário, mantidos para a recarga da base durante a execução
+char* base_file = NULL;
+char* journal_path = NULL;
+
+// Índice espacial (motor) usado nas consultas
+const SpatialIndex* engine = NULL;
+
+// Limites dos pontos de recarga, calculados a partir da base e usados na
+// construção do índice
+Boundary base_boundary = INVALIDBOUNDARY;
+
+// Indica se as consultas C devem ser executadas em lote (opção -z)
+bool batch_mode = false;
+
+// Indica se o mapa ilustrativo deve ser gerado a cada consulta
+bool map_enabled = true;
+
+// Indica se os resultados das consultas devem ser comparados aos da 
+// varredura linear (opção -v), e os totais de consultas comparadas e de 
+// divergências encontradas
+bool validate = false;
+long validated = 0;
+long mismatches = 0;
+
+// Tolerância relativa na comparação das distâncias durante a validação
+#define VALIDATE_TOLERANCE 1e-9
+
+// Arquivo em que os resultados dos comandos são escritos
+FILE* output = NULL;
+
 // Função para imprimir as informações do ponto de recarga
-// Recebe a posição do nó na quadtree como argumento
-void printrecharge(int pos) 
+// Recebe o identificador do ponto de recarga como argumento
+void printrecharge(long id) 
 {
-	QuadTreeNode aux;
-	// Recupera as informações do nó na quadtree
-	node_get(pos, &aux);
+	// Recupera as informações do ponto de recarga
+	Item* it = station_get(id);
 	// Imprime os detalhes do ponto de recarga
-	printf("%s %s, %d, %s, %s, %d", aux.key.sigla_tipo,
-				aux.key.nome_logra, aux.key.numero_imo,
-				aux.key.nome_bairr, aux.key.nome_regio,
-				aux.key.cep);
+	fprintf(output, "%s %s, %d, %s, %s, %d", it->sigla_tipo,
+				it->nome_logra, it->numero_imo,
+				it->nome_bairr, it->nome_regio,
+				it->cep);
 }
 
 // Função para imprimir um mapa ilustrativo usando gnuplot
@@ -84,17 +220,13 @@ void printmap(Neighbor* kvet, int kmax, int nrec, double tx, double ty)
 	out1 = fopen("plot/recharge.gpdat","wt");
 	// Pontos de recarga desativados
     out2 = fopen("plot/deactivated.gpdat","wt");
-	QuadTreeNode aux;
-	for (int i = 0; i < nrec; i++) {
-		node_get(i, &aux);
-		if (aux.key.idend == NULL) {
-			continue;
-		}
-		if (!aux.key.ativo) {
-			fprintf(out2,"%f %f\n", aux.key.x, aux.key.y);
-			continue;
-		}
-		fprintf(out1,"%f %f\n", aux.key.x, aux.key.y);
+	for (long i = station_next(0, true); i != INVALIDSTATION && i < nrec; i = station_next(i + 1, true)) {
+		Item* it = station_get(i);
+		fprintf(out1,"%f %f\n", it->x, it->y);
+	}
+	for (long i = station_next(0, false); i != INVALIDSTATION && i < nrec; i = station_next(i + 1, false)) {
+		Item* it = station_get(i);
+		fprintf(out2,"%f %f\n", it->x, it->y);
 	}
 	fclose(out1);
 	fclose(out2);
@@ -102,8 +234,8 @@ void printmap(Neighbor* kvet, int kmax, int nrec, double tx, double ty)
 	// Os pontos de recarga mais próximos
 	out1 = fopen("plot/suggested.gpdat","wt");
 	for (int i = 0; i < kmax; i++) {
-		node_get(kvet[i].addr, &aux);
-		fprintf(out1,"%f %f\n", aux.key.x, aux.key.y);
+		Item* it = station_get(kvet[i].id);
+		fprintf(out1,"%f %f\n", it->x, it->y);
 	}
 	fclose(out1);
 }
@@ -119,7 +251,7 @@ typedef struct {
 Query* vet;
 
 // Função de busca binária para encontrar um ponto de recarga pelo ID, de modo 
-// a permitir a busca na quadtree pelas coordenadas
+// a permitir a busca no índice espacial pelas coordenadas
 Query* bin_search(char* idend, Query* vet, int n) 
 {
 	int l = 0, r = n - 1;
@@ -151,85 +283,35 @@ int cmp_idend(const void* a, const void* b)
 // Função para carregar os pontos de recarga a partir de um arquivo
 void load_recharge_stations(const char* filename) 
 {
-    // Abre o arquivo para leitura
-    FILE* file = fopen(filename, "r");
-    if (file == NULL) {
-        // Se o arquivo não puder ser aberto, imprime uma mensagem de erro e 
-        // encerra o programa
-        fprintf(stderr, "Erro: nao foi possivel abrir o arquivo %s\n", filename);
+    // Lê os pontos de recarga em paralelo, diretamente no vetor
+    long n = loader_read_base(filename, nthreads);
+    if (n < 0) {
         exit(1);
     }
+    nrecharge = (int) n;
 
-    // Lê o arquivo e popula a quadtree
-    char buffer[1024];
-    if (fgets(buffer, sizeof(buffer), file) == NULL) {
-        // Se não for possível ler o número de pontos de recarga, imprime uma 
-        // mensagem de erro e encerra o programa
-        fprintf(stderr, "Erro: nao foi possivel ler o numero de pontos de recarga\n");
-        fclose(file);      
-        exit(1);
-    }	
-    
-    // Remove o caractere de nova linha, se presente
-    buffer[strcspn(buffer, "\n")] = 0;
-    // Converte a string lida para um número inteiro e armazena em nrecharge
-    sscanf(buffer, "%d", &nrecharge);
-
-    // Cria a quadtree com a capacidade calculada e os limites especificados
-	// (extraidos do arquivo que contem os pontos de recarga em potencial)
-    quadtree_create(4 * nrecharge - 1, (Boundary) {598017.313632323, 619122.989979841, 7785041.75619417, 7812836.09085508});
-    // Aloca memória para o vetor de consultas
+    // Monta o vetor de consultas, que compartilha os identificadores com o
+    // vetor de pontos de recarga
     vet = malloc(nrecharge * sizeof(Query));
+    for (int i = 0; i < nrecharge; i++) {
+        Item* it = station_get(i);
+        vet[i].idend = it->idend;
+        vet[i].x = it->x;
+        vet[i].y = it->y;
+    }
 
-    Item aux;
-    int i = 0;
-    while (fgets(buffer, sizeof(buffer), file)) {
-        // Remove o caractere de nova linha, se presente
-        buffer[strcspn(buffer, "\n")] = 0;
-
-        // Faz o parsing da linha
-        char* token = strtok(buffer, ";");
-        aux.idend = strdup(token);
-        vet[i].idend = strdup(token);
-        
-        token = strtok(NULL, ";");
-        aux.id_logrado = atol(token);
-
-        token = strtok(NULL, ";");
-        aux.sigla_tipo = strdup(token);
-
-        token = strtok(NULL, ";");
-        aux.nome_logra = strdup(token);
-
-        token = strtok(NULL, ";");
-        aux.numero_imo = atoi(token);
-
-        token = strtok(NULL, ";");
-        aux.nome_bairr = strdup(token);
-
-        token = strtok(NULL, ";");
-        aux.nome_regio = strdup(token);
-
-        token = strtok(NULL, ";");
-        aux.cep = atoi(token);
-
-        token = strtok(NULL, ";");
-        aux.x = atof(token);
-        vet[i].x = atof(token);
-
-        token = strtok(NULL, ";");
-        aux.y = atof(token);
-        vet[i].y = atof(token);
+    // Codifica os atributos usados pelos filtros, antes da construção do 
+    // índice, que resume os atributos de cada subárvore
+    filter_build();
 
-        // Marca o ponto de recarga como ativo
-        aux.ativo = true;
-        
-        // Insere o ponto de recarga na quadtree
-        quadtree_insert(aux);
-        i++;
+    // Constrói o índice espacial com os limites dos pontos de recarga, de 
+    // modo que nenhum ponto fica de fora, qualquer que seja a cidade
+    base_boundary = station_boundary();
+    engine->build(base_boundary);
+    if (validate) {
+        scan_build(base_boundary);
     }
-    // Fecha o arquivo
-    fclose(file);
+    tiles_build(base_boundary);
 
     // Ordena o vetor de consultas pelo ID
     qsort(vet, nrecharge, sizeof(Query), cmp_idend);
@@ -247,29 +329,26 @@ void activate_recharge_station(char* id)
         return;
     }
     
-    // Busca na quadtree pelo endereço do ponto de recarga
-    nodeaddr_t addr = quadtree_search(id, query->x, query->y);
-    if (addr == INVALIDADDR) {
+    // Busca no índice espacial pelo ponto de recarga
+    long sid = engine->search(id, query->x, query->y);
+    if (sid == INVALIDSTATION) {
         // Se o endereço não for encontrado, imprime uma mensagem de erro e 
         // retorna
         fprintf(stderr, "Ponto de recarga %s não encontrado.\n", id);
         return;
     }
 
-    QuadTreeNode node;
-    // Recupera o nó da quadtree
-    node_get(addr, &node);
-    if (node.key.ativo) {
+    latency_mark(LAT_SEARCH);
+    if (station_is_active(sid)) {
         // Se o ponto de recarga já estiver ativo, imprime uma mensagem e
         // retorna
-        printf("Ponto de recarga %s já estava ativo.\n", id);
+        fprintf(output, "Ponto de recarga %s já estava ativo.\n", id);
         return;
     }
-    // Ativa o ponto de recarga
-    node.key.ativo = true;
-    // Atualiza o nó na quadtree
-    node_put(addr, &node);
-    printf("Ponto de recarga %s ativado.\n", id);
+    // Ativa o ponto de recarga e registra o evento no diário
+    spindex_set_active(engine, sid, true);
+    journal_append(JOURNAL_ACTIVATE, sid);
+    fprintf(output, "Ponto de recarga %s ativado.\n", id);
 }
 
 // Função para desativar um ponto de recarga
@@ -284,47 +363,628 @@ void deactivate_recharge_station(char* id)
         return;
     }
     
-    // Busca na quadtree pelo endereço do ponto de recarga
-    nodeaddr_t addr = quadtree_search(id, query->x, query->y);
-    if (addr == INVALIDADDR) {
+    // Busca no índice espacial pelo ponto de recarga
+    long sid = engine->search(id, query->x, query->y);
+    if (sid == INVALIDSTATION) {
         // Se o endereço não for encontrado, imprime uma mensagem de erro e
         // retorna
         fprintf(stderr, "Ponto de recarga %s não encontrado.\n", id);
         return;
     }
 
-    QuadTreeNode node;
-    // Recupera o nó da quadtree
-    node_get(addr, &node);
-    if (!node.key.ativo) {
+    latency_mark(LAT_SEARCH);
+    if (!station_is_active(sid)) {
         // Se o ponto de recarga já estiver desativado, imprime uma mensagem e
         // retorna
-        printf("Ponto de recarga %s já estava desativado.\n", id);
+        fprintf(output, "Ponto de recarga %s já estava desativado.\n", id);
+        return;
+    }
+    // Desativa o ponto de recarga e registra o evento no diário
+    spindex_set_active(engine, sid, false);
+    journal_append(JOURNAL_DEACTIVATE, sid);
+    fprintf(output, "Ponto de recarga %s desativado.\n", id);
+}
+
+// Função para imprimir os n pontos de recarga mais próximos encontrados
+void print_closest(Neighbor* result, long n) 
+{
+    for (int i = 0; i < n; i++) {
+        printrecharge(result[i].id);
+        fprintf(output, " (%.3f)\n", result[i].dist);
+    }
+}
+
+// Função para imprimir, para cada polígono do arquivo filename, o número de 
+// pontos de recarga ativos dentro dele e, se count for falso, os próprios 
+// pontos, em ordem de identificador
+void polygon_report(const char* filename, bool count) 
+{
+    // Os polígonos são lidos a cada comando e liberados de uma só vez
+    Arena arena = EMPTYARENA;
+    long npolys;
+    Polygon* polys = polygon_read(filename, &npolys, &arena);
+    if (polys == NULL) {
+        arena_release(&arena);
         return;
     }
-    // Desativa o ponto de recarga
-    node.key.ativo = false;
-    // Atualiza o nó na quadtree
-    node_put(addr, &node);
-    printf("Ponto de recarga %s desativado.\n", id);
+    long* ids = count ? NULL : malloc((nrecharge > 0 ? nrecharge : 1) * sizeof(long));
+    for (long i = 0; i < npolys; i++) {
+        long n = spindex_polygon(engine, &polys[i], ids);
+        fprintf(output, "%s %ld\n", polys[i].name, n);
+        for (long j = 0; ids != NULL && j < n; j++) {
+            printrecharge(ids[j]);
+            fprintf(output, "\n");
+        }
+    }
+    free(ids);
+    arena_release(&arena);
 }
 
-// Função para encontrar os n pontos de recarga mais próximos
-void closest_recharge_stations(double x, double y, long n) 
+// Função para imprimir os pontos de recarga ativos a até d da rota cujos 
+// vértices, pares "x y", ocupam a string points, em ordem de distância à 
+// rota e com o vértice da rota mais próximo de cada um
+void corridor_report(double d, char* points) 
+{
+    // Lê os vértices da rota
+    long nv = 0, cap = 16;
+    double* xs = malloc(cap * sizeof(double));
+    double* ys = malloc(cap * sizeof(double));
+    char* p = points;
+    char* end;
+    for (;;) {
+        // Um vértice só é aceito se as duas coordenadas forem lidas
+        char* q;
+        double x = strtod(p, &q);
+        if (q == p) break;
+        double y = strtod(q, &end);
+        if (end == q) break;
+        p = end;
+        if (nv == cap) {
+            cap *= 2;
+            xs = realloc(xs, cap * sizeof(double));
+            ys = realloc(ys, cap * sizeof(double));
+        }
+        xs[nv] = x;
+        ys[nv] = y;
+        nv++;
+    }
+    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+    if (nv == 0 || *p != 0) {
+        fprintf(stderr, "Comando inválido.\n");
+        free(xs);
+        free(ys);
+        return;
+    }
+
+    // Imprime o cabeçalho com a rota lida
+    fprintf(output, "Q %lf", d);
+    for (long v = 0; v < nv; v++) {
+        fprintf(output, " %lf %lf", xs[v], ys[v]);
+    }
+    fprintf(output, "\n");
+
+    // Encontra os pontos do corredor com uma única travessia do índice
+    Route route = {nv, xs, ys};
+    Neighbor* result = malloc((nrecharge + 1) * sizeof(Neighbor));
+    long n = spindex_corridor(engine, &route, d, result);
+    for (long i = 0; i < n; i++) {
+        Item* it = station_get(result[i].id);
+        printrecharge(result[i].id);
+        fprintf(output, " (%.3f) vertice %ld\n", result[i].dist, route_nearest_vertex(&route, it->x, it->y) + 1);
+    }
+    free(result);
+    free(xs);
+    free(ys);
+}
+
+// Função para ativar ou desativar todos os pontos de recarga de um bairro
+void bulk_recharge_stations(char* bairro, bool ativo) 
+{
+    // Recupera os pontos de recarga do bairro
+    long n;
+    const long* ids = station_bairro(bairro, &n);
+    if (n == 0) {
+        // Se o bairro não tiver pontos de recarga, imprime uma mensagem de 
+        // erro e retorna
+        fprintf(stderr, "Bairro %s não encontrado.\n", bairro);
+        return;
+    }
+
+    // Altera os pontos de recarga em uma única operação e registra no diário
+    // apenas os que mudaram de status
+    long* changed = (long*) malloc(n * sizeof(long));
+    long nchanged = spindex_set_active_list(engine, ids, n, ativo, changed);
+    for (long i = 0; i < nchanged; i++) {
+        journal_append(ativo ? JOURNAL_ACTIVATE : JOURNAL_DEACTIVATE, changed[i]);
+    }
+    free(changed);
+    fprintf(output, "%ld de %ld pontos de recarga do bairro %s %s.\n", nchanged, n, 
+            bairro, ativo ? "ativados" : "desativados");
+}
+
+// Função para comparar os found vizinhos de (x, y) encontrados pelo motor aos
+// da varredura linear, que servem de referência. Como pontos à mesma 
+// distância podem aparecer em qualquer ordem, apenas as distâncias são 
+// comparadas; cada divergência é impressa na saída de erro
+void validate_knn(double x, double y, long n, const Filter* filter, const Neighbor* result, long found) 
+{
+    Neighbor* expected = malloc((n > 0 ? n : 1) * sizeof(Neighbor));
+    long nexpected = spindex_knn(&scan_index, x, y, n, filter, expected);
+    bool ok = nexpected == found;
+    for (long i = 0; ok && i < found; i++) {
+        double diff = fabs(result[i].dist - expected[i].dist);
+        if (diff > VALIDATE_TOLERANCE * fmax(1.0, expected[i].dist)) ok = false;
+    }
+    validated++;
+    if (!ok) {
+        mismatches++;
+        fprintf(stderr, "Validacao: divergencia em %lf %lf %ld: %ld vizinhos (esperados %ld)\n", 
+                x, y, n, found, nexpected);
+    }
+    free(expected);
+}
+
+// Função para encontrar os n pontos de recarga mais próximos que satisfazem
+// o filtro (NULL para nenhum)
+void closest_recharge_stations(double x, double y, long n, const Filter* filter) 
 {
     // Array para armazenar os resultados dos pontos de recarga mais próximos
     Neighbor result[n];
     
-    // Encontra os n pontos de recarga mais próximos usando a quadtree
-    quadtree_knn(x, y, n, result);
+    // Encontra os n pontos de recarga mais próximos usando o índice espacial
+    long found = spindex_knn(engine, x, y, n, filter, result);
+    latency_mark(LAT_SEARCH);
+    if (validate) {
+        validate_knn(x, y, n, filter, result, found);
+    }
     
-    // Imprime os n pontos de recarga mais próximos
-    QuadTreeNode aux;
-    for (int i = 0; i < n; i++) {
-        printrecharge(result[i].addr);
-        printf(" (%.3f)\n", result[i].dist);
+    // Imprime os pontos de recarga encontrados, que podem ser menos que n se
+    // não houver pontos ativos (ou que satisfaçam o filtro) suficientes
+    print_closest(result, found);
+    if (map_enabled) {
+        printmap(result, found, nrecharge, x, y);
+    }
+}
+
+// Cursor da consulta paginada aberta (NULL se não houver)
+void* cursor = NULL;
+
+// Função para imprimir a próxima página de até n pontos de recarga da 
+// consulta paginada aberta
+void next_page(long n) 
+{
+    if (cursor == NULL) {
+        fprintf(stderr, "Nenhuma consulta paginada aberta.\n");
+        return;
+    }
+    Neighbor* result = (Neighbor*) malloc((n > 0 ? n : 1) * sizeof(Neighbor));
+    long found = engine->cursor_next(cursor, n, result);
+    latency_mark(LAT_SEARCH);
+    print_closest(result, found);
+    free(result);
+}
+
+// Função para abrir uma consulta paginada a partir de (x, y), substituindo a
+// anterior, e imprimir sua primeira página de até n pontos de recarga
+void open_page(double x, double y, long n) 
+{
+    if (engine->cursor_open == NULL) {
+        fprintf(stderr, "Motor %s não oferece consultas paginadas.\n", engine->name);
+        return;
+    }
+    if (cursor != NULL) engine->cursor_close(cursor);
+    cursor = engine->cursor_open(x, y, NULL);
+    next_page(n);
+}
+
+// Estrutura para armazenar uma consulta C pendente no lote
+typedef struct {
+    double x;           // Coordenada x da consulta
+    double y;           // Coordenada y da consulta
+    long n;             // Número de pontos de recarga solicitados
+    uint32_t code;      // Código de Morton de (x, y)
+    long order;         // Posição da consulta no lote, na ordem de leitura
+    Neighbor* result;   // Resultados (NULL se a consulta for inválida)
+    long found;         // Número de resultados encontrados
+    uint64_t phase_ns[LAT_NPHASES]; // Tempo gasto em cada fase
+    uint64_t faults;    // Faltas de página durante a busca
+    uint64_t hits;      // Acertos no pool de páginas durante a busca
+} BatchQuery;
+
+// Lote de consultas C pendentes
+BatchQuery* batch = NULL;
+long batchsz = 0; // Número de consultas no lote
+long batchcap = 0; // Capacidade do vetor do lote
+
+// Função de comparação para ordenar as consultas do lote pelo código de 
+// Morton, mantendo a ordem de leitura em caso de empate
+int cmp_morton(const void* a, const void* b) 
+{
+	BatchQuery* q1 = *(BatchQuery**) a;
+	BatchQuery* q2 = *(BatchQuery**) b;
+	if (q1->code != q2->code) return q1->code > q2->code ? 1 : -1;
+	if (q1->order != q2->order) return q1->order > q2->order ? 1 : -1;
+	return 0;
+}
+
+// Função para adicionar uma consulta C ao lote
+void batch_add(double x, double y, long n, uint64_t parse_ns) 
+{
+    // Aumenta o vetor do lote, se necessário
+    if (batchsz == batchcap) {
+        batchcap = batchcap ? 2 * batchcap : 64;
+        batch = realloc(batch, batchcap * sizeof(BatchQuery));
+    }
+    batch[batchsz] = (BatchQuery) {x, y, n, morton_encode(&base_boundary, x, y), batchsz, NULL, 0, {0}, 0, 0};
+    batch[batchsz].phase_ns[LAT_PARSE] = parse_ns;
+    batchsz++;
+}
+
+// Função para executar as consultas do lote na ordem do código de Morton, o 
+// que faz consultas próximas percorrerem as mesmas regiões do índice em 
+// sequência, e imprimir os resultados na ordem original
+void batch_flush() 
+{
+    if (batchsz == 0) return;
+
+    // Ordena ponteiros para as consultas pelo código de Morton
+    BatchQuery** sorted = malloc(batchsz * sizeof(BatchQuery*));
+    for (long i = 0; i < batchsz; i++) {
+        sorted[i] = &batch[i];
+    }
+    qsort(sorted, batchsz, sizeof(BatchQuery*), cmp_morton);
+
+    // Descarta as consultas inválidas, mantendo a ordem espacial
+    long nvalid = 0;
+    for (long i = 0; i < batchsz; i++) {
+        BatchQuery* q = sorted[i];
+        if (q->n > nrecharge) continue;
+        q->result = malloc((q->n > 0 ? q->n : 1) * sizeof(Neighbor));
+        sorted[nvalid++] = q;
+    }
+
+    if (node_paged()) {
+        // No modo paginado, as consultas são executadas uma a uma, para que
+        // as faltas de página sejam atribuídas a cada consulta
+        for (long i = 0; i < nvalid; i++) {
+            BatchQuery* q = sorted[i];
+            uint64_t start = latency_now();
+            uint64_t faults, hits;
+            latency_page_counts(&faults, &hits);
+            q->found = spindex_knn(engine, q->x, q->y, q->n, NULL, q->result);
+            q->phase_ns[LAT_SEARCH] = latency_now() - start;
+            latency_page_counts(&q->faults, &q->hits);
+            q->faults -= faults;
+            q->hits -= hits;
+        }
+    }
+    else if (nvalid > 0) {
+        // As consultas são executadas de forma intercalada pelo motor, de modo
+        // que o tempo de busca de cada uma é a média do lote
+        double* xs = malloc(nvalid * sizeof(double));
+        double* ys = malloc(nvalid * sizeof(double));
+        long* ks = malloc(nvalid * sizeof(long));
+        long* found = malloc(nvalid * sizeof(long));
+        Neighbor** results = malloc(nvalid * sizeof(Neighbor*));
+        for (long i = 0; i < nvalid; i++) {
+            xs[i] = sorted[i]->x;
+            ys[i] = sorted[i]->y;
+            ks[i] = sorted[i]->n;
+            results[i] = sorted[i]->result;
+        }
+        uint64_t start = latency_now();
+        spindex_knn_batch(engine, xs, ys, ks, nvalid, results, found);
+        uint64_t elapsed = latency_now() - start;
+        for (long i = 0; i < nvalid; i++) {
+            sorted[i]->found = found[i];
+            sorted[i]->phase_ns[LAT_SEARCH] = elapsed / nvalid;
+        }
+        free(xs);
+        free(ys);
+        free(ks);
+        free(found);
+        free(results);
+    }
+    free(sorted);
+    if (validate) {
+        for (long i = 0; i < batchsz; i++) {
+            BatchQuery* q = &batch[i];
+            if (q->result != NULL) validate_knn(q->x, q->y, q->n, NULL, q->result, q->found);
+        }
+    }
+
+    // Imprime os resultados na ordem original
+    BatchQuery* last = NULL;
+    for (long i = 0; i < batchsz; i++) {
+        BatchQuery* q = &batch[i];
+        uint64_t start = latency_now();
+        fprintf(output, "C %lf %lf %ld\n", q->x, q->y, q->n);
+        if (q->result == NULL) {
+            fprintf(stderr, "Número de pontos de recarga solicitados maior que o número de pontos de recarga disponíveis.\n");
+        }
+        else {
+            print_closest(q->result, q->found);
+            last = q;
+        }
+        q->phase_ns[LAT_OUTPUT] = latency_now() - start;
+
+        // Registra a latência da consulta, cujas fases não foram contíguas
+        int series = latency_series('C', q->n);
+        uint64_t total = 0;
+        for (int p = 0; p < LAT_TOTAL; p++) {
+            latency_record(series, p, q->phase_ns[p]);
+            total += q->phase_ns[p];
+        }
+        latency_record(series, LAT_TOTAL, total);
+        if (node_paged()) {
+            latency_record_pages(series, q->faults, q->hits);
+        }
+    }
+
+    // Como não há eventos A/D no lote, o mapa da última consulta válida é o 
+    // mesmo que seria gerado na execução sequencial
+    if (last != NULL && map_enabled) {
+        printmap(last->result, last->found, nrecharge, last->x, last->y);
+    }
+    for (long i = 0; i < batchsz; i++) {
+        free(batch[i].result);
+    }
+    batchsz = 0;
+}
+
+// Função para reaplicar um evento do diário sobre o índice espacial
+void apply_journal_event(long id, bool ativo) 
+{
+    spindex_set_active(engine, id, ativo);
+}
+
+// Função para liberar os pontos de recarga, o índice espacial e os dados
+// associados
+void unload_recharge_stations() 
+{
+    if (cursor != NULL) engine->cursor_close(cursor);
+    cursor = NULL;
+    engine->destroy();
+    scan_destroy();
+    tiles_destroy();
+    filter_destroy();
+    // As strings dos pontos de recarga, compartilhadas com o vetor de 
+    // consultas, são liberadas junto com a arena
+    station_destroy();
+    free(vet);
+    vet = NULL;
+    nrecharge = 0;
+}
+
+// Função para recarregar a base durante a execução: libera todos os dados,
+// lê a base novamente e reaplica o diário, se houver
+void reload_recharge_stations() 
+{
+    journal_close();
+    unload_recharge_stations();
+    load_recharge_stations(base_file);
+    if (journal_path != NULL && journal_open(journal_path, apply_journal_event) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel reabrir o diario %s\n", journal_path);
+    }
+    fprintf(output, "%d pontos de recarga carregados.\n", nrecharge);
+}
+
+// Função para imprimir a memória alocada por cada parte do programa, em bytes
+void memory_report() 
+{
+    size_t stations = station_memory();
+    size_t strings = station_strings_memory();
+    size_t queries = nrecharge * sizeof(Query);
+    size_t index = engine->memory();
+    size_t filters = filter_memory();
+    size_t caches = station_cache_memory();
+    size_t tiles = tiles_memory();
+    // Os vetores da varredura construídos para a validação (opção -v) só são
+    // contados à parte quando não pertencem ao próprio motor
+    size_t reference = validate && engine != &scan_index && engine != &auto_index ? scan_memory() : 0;
+    fprintf(output, "pontos de recarga: %zu\n", stations);
+    fprintf(output, "strings: %zu\n", strings);
+    fprintf(output, "consultas: %zu\n", queries);
+    fprintf(output, "indice %s: %zu\n", engine->name, index);
+    fprintf(output, "filtros: %zu\n", filters);
+    fprintf(output, "caches: %zu\n", caches);
+    fprintf(output, "tiles: %zu\n", tiles);
+    if (validate) fprintf(output, "validacao: %zu\n", reference);
+    fprintf(output, "total: %zu\n", stations + strings + queries + index + filters + caches + tiles + reference);
+    if (node_paged()) {
+        uint64_t faults, hits;
+        node_page_stats(&faults, &hits);
+        fprintf(output, "paginas: %lu faltas, %lu acertos (taxa %.4f)\n", (unsigned long) faults, 
+                (unsigned long) hits, faults + hits ? (double) hits / (faults + hits) : 1.0);
+    }
+}
+
+// Função para executar um comando, já sem o caractere de nova linha
+void execute_command(char* buffer) 
+{
+    char operation, op;
+    char id[20];
+    char field[16];
+    int pos = 0;
+    int nread, zoom;
+    Filter filter;
+    Boundary view;
+
+    double x, y, maxdist;
+    long n, m;
+    
+    // Inicia a medição de latência do comando
+    latency_begin();
+
+    // Verifica o tipo de operação a ser realizada
+    switch (buffer[0]) {
+    case 'A':
+        // Ativar ponto de recarga
+        sscanf(buffer, "%c %19s", &operation, id);
+        latency_mark(LAT_PARSE);
+        fprintf(output, "%c %s\n", operation, id);
+
+        // Chama a função para ativar o ponto de recarga
+        activate_recharge_station(id);
+        latency_mark(LAT_OUTPUT);
+        latency_end(latency_series('A', 0));
+        
+        break;
+    case 'D':
+        // Desativar ponto de recarga
+        sscanf(buffer, "%c %19s", &operation, id);
+        latency_mark(LAT_PARSE);
+        fprintf(output, "%c %s\n", operation, id);
+
+        // Chama a função para desativar o ponto de recarga
+        deactivate_recharge_station(id);
+        latency_mark(LAT_OUTPUT);
+        latency_end(latency_series('D', 0));
+        
+        break;
+    case 'C':
+        // Encontrar n pontos de recarga mais próximos
+        sscanf(buffer, "%c %lf %lf %ld", &operation, &x, &y, &n);
+        latency_mark(LAT_PARSE);
+        fprintf(output, "%c %lf %lf %ld\n", operation, x, y, n);
+
+        // Verifica se o número de pontos de recarga solicitados é maior
+        // que o disponível
+        if (n > nrecharge) {
+            fprintf(stderr, "Número de pontos de recarga solicitados maior que o número de pontos de recarga disponíveis.\n");
+            break;
+        }
+        // Chama a função para encontrar os pontos de recarga mais próximos
+        closest_recharge_stations(x, y, n, NULL);
+        latency_mark(LAT_OUTPUT);
+        latency_end(latency_series('C', n));
+        
+        break;
+    case 'F':
+        // Encontrar n pontos de recarga mais próximos que satisfazem um 
+        // filtro; o valor do filtro ocupa o restante da linha
+        if (sscanf(buffer, "%c %lf %lf %ld %15s %n", &operation, &x, &y, &n, field, &pos) < 5 ||
+            filter_parse(&filter, field, buffer + pos) < 0) {
+            fprintf(stderr, "Comando inválido.\n");
+            break;
+        }
+        fprintf(output, "%c %lf %lf %ld %s %s\n", operation, x, y, n, field, buffer + pos);
+        if (n > nrecharge) {
+            fprintf(stderr, "Número de pontos de recarga solicitados maior que o número de pontos de recarga disponíveis.\n");
+            break;
+        }
+        closest_recharge_stations(x, y, n, &filter);
+        
+        break;
+    case 'P':
+        // Abrir uma consulta paginada e imprimir a primeira página
+        if (sscanf(buffer, "%c %lf %lf %ld", &operation, &x, &y, &n) < 4 || n < 0) {
+            fprintf(stderr, "Comando inválido.\n");
+            break;
+        }
+        fprintf(output, "%c %lf %lf %ld\n", operation, x, y, n);
+        open_page(x, y, n);
+        
+        break;
+    case 'M':
+        // Imprimir a próxima página da consulta paginada
+        if (sscanf(buffer, "%c %ld", &operation, &n) < 2 || n < 0) {
+            fprintf(stderr, "Comando inválido.\n");
+            break;
+        }
+        fprintf(output, "%c %ld\n", operation, n);
+        next_page(n);
+        
+        break;
+    case 'U':
+        // Relatório de memória
+        fprintf(output, "U\n");
+        memory_report();
+        
+        break;
+    case 'R':
+        // Recarregar a base
+        fprintf(output, "R\n");
+        reload_recharge_stations();
+        
+        break;
+    case 'B':
+        // Ativar ou desativar todos os pontos de recarga de um bairro, cujo
+        // nome ocupa o restante da linha
+        if (sscanf(buffer, "%c %c %n", &operation, &op, &pos) < 2 || (op != 'A' && op != 'D') || 
+            buffer[pos] == 0) {
+            fprintf(stderr, "Comando inválido.\n");
+            break;
+        }
+        fprintf(output, "%c %c %s\n", operation, op, buffer + pos);
+        bulk_recharge_stations(buffer + pos, op == 'A');
+        
+        break;
+    case 'G':
+    case 'K':
+        // Listar ou contar os pontos de recarga ativos dentro de cada 
+        // polígono do arquivo, cujo nome ocupa o restante da linha
+        if (sscanf(buffer, "%c %n", &operation, &pos) < 1 || buffer[pos] == 0) {
+            fprintf(stderr, "Comando inválido.\n");
+            break;
+        }
+        fprintf(output, "%c %s\n", operation, buffer + pos);
+        polygon_report(buffer + pos, operation == 'K');
+        
+        break;
+    case 'T':
+        // Imprimir os tiles de um nível da pirâmide, opcionalmente apenas os
+        // que interceptam um retângulo
+        nread = sscanf(buffer, "%c %d %lf %lf %lf %lf", &operation, &zoom, &view.x_min, &view.y_min, 
+                       &view.x_max, &view.y_max);
+        if ((nread != 2 && nread != 6) || zoom < 0 || zoom > TILES_MAXZOOM) {
+            fprintf(stderr, "Comando inválido.\n");
+            break;
+        }
+        if (nread == 6) {
+            fprintf(output, "%c %d %lf %lf %lf %lf\n", operation, zoom, view.x_min, view.y_min, view.x_max, view.y_max);
+        }
+        else {
+            fprintf(output, "%c %d\n", operation, zoom);
+        }
+        tiles_write(output, zoom, nread == 6 ? &view : NULL);
+        
+        break;
+    case 'H':
+        // Calcular o mapa de distâncias ao ponto ativo mais próximo, cujo 
+        // arquivo ocupa o restante da linha
+        if (sscanf(buffer, "%c %ld %ld %n", &operation, &n, &m, &pos) < 3 || buffer[pos] == 0) {
+            fprintf(stderr, "Comando inválido.\n");
+            break;
+        }
+        fprintf(output, "%c %ld %ld %s\n", operation, n, m, buffer + pos);
+        maxdist = raster_write(engine, buffer + pos, n, m, base_boundary, nthreads);
+        if (maxdist >= 0) {
+            fprintf(output, "Mapa de %ldx%ld células gravado em %s (distância máxima %lf).\n", n, m, buffer + pos, maxdist);
+        }
+        
+        break;
+    case 'Q':
+        // Encontrar os pontos de recarga no corredor de largura d em torno de
+        // uma rota, cujos vértices ocupam o restante da linha
+        if (sscanf(buffer, "%c %lf %n", &operation, &x, &pos) < 2 || x < 0) {
+            fprintf(stderr, "Comando inválido.\n");
+            break;
+        }
+        corridor_report(x, buffer + pos);
+        
+        break;
+    case 'S':
+        // Contar os pontos de recarga ativos
+        fprintf(output, "S\n");
+        fprintf(output, "%ld de %ld pontos de recarga ativos.\n", station_count_active(), station_count());
+        
+        break;
+    default:
+        // Comando inválido
+        fprintf(stderr, "Comando inválido.\n");
+        break;
     }
-    printmap(result, n, nrecharge, x, y);
 }
 
 // Função para ler e executar comandos a partir de um arquivo
@@ -339,12 +999,16 @@ void read_commands(const char* filename)
         exit(1);
     }
 
-    char buffer[1024];
+    // As linhas são lidas com tamanho variável, já que o comando Q pode ter 
+    // rotas com muitos vértices
+    char* buffer = NULL;
+    size_t bufcap = 0;
     // Lê a primeira linha do arquivo para obter o número de comandos
-    if (fgets(buffer, sizeof(buffer), file) == NULL) {
+    if (getline(&buffer, &bufcap, file) < 0) {
         // Se não for possível ler o número de comandos, imprime uma mensagem
         // de erro e encerra o programa
         fprintf(stderr, "Erro: nao foi possivel ler o numero de comandos\n");
+        free(buffer);
         fclose(file);
         exit(1);
     }
@@ -353,96 +1017,244 @@ void read_commands(const char* filename)
     sscanf(buffer, "%d", &num_commands);
 
     // Itera sobre cada comando no arquivo
-    while (fgets(buffer, sizeof(buffer), file)) {
+    while (getline(&buffer, &bufcap, file) >= 0) {
         // Remove o caractere de nova linha, se presente
         buffer[strcspn(buffer, "\n")] = 0;
 
-        char operation;
-        char id[20];
-
-        double x, y;
-        long n;
-        
-        // Verifica o tipo de operação a ser realizada
-        switch (buffer[0]) {
-        case 'A':
-            // Ativar ponto de recarga
-            sscanf(buffer, "%c %s", &operation, id);
-            printf("%c %s\n", operation, id);
-
-            // Chama a função para ativar o ponto de recarga
-            activate_recharge_station(id);
-            
-            break;
-        case 'D':
-            // Desativar ponto de recarga
-            sscanf(buffer, "%c %s", &operation, id);
-            printf("%c %s\n", operation, id);
-
-            // Chama a função para desativar o ponto de recarga
-            deactivate_recharge_station(id);
-            
-            break;
-        case 'C':
-            // Encontrar n pontos de recarga mais próximos
+        // No modo em lote, as consultas C são acumuladas até o próximo 
+        // comando de outro tipo
+        if (batch_mode && buffer[0] == 'C') {
+            char operation;
+            double x, y;
+            long n;
+            uint64_t start = latency_now();
             sscanf(buffer, "%c %lf %lf %ld", &operation, &x, &y, &n);
-            printf("%c %lf %lf %ld\n", operation, x, y, n);
-
-            // Verifica se o número de pontos de recarga solicitados é maior
-            // que o disponível
-            if (n > nrecharge) {
-                fprintf(stderr, "Número de pontos de recarga solicitados maior que o número de pontos de recarga disponíveis.\n");
-                break;
-            }
-            // Chama a função para encontrar os pontos de recarga mais próximos
-            closest_recharge_stations(x, y, n);
-            
-            break;
-        default:
-            // Comando inválido
-            fprintf(stderr, "Comando inválido.\n");
-            break;
+            batch_add(x, y, n, latency_now() - start);
+            continue;
         }
+        batch_flush();
+
+        // Executa o comando
+        execute_command(buffer);
+        // Escreve o relatório de latência, se solicitado por sinal
+        latency_poll();
     }
+    // Executa as consultas que restaram no lote
+    batch_flush();
+    free(batch);
+    batch = NULL;
+    batchcap = 0;
+    free(buffer);
+    fclose(file);
 }
 
-int main(int argc, char** argv) 
-{	
-    // Verifica se o número de argumentos é igual a 5
-    if (argc != 5) {
-        // Imprime mensagem de uso correto do programa
-        fprintf(stderr, "Uso: %s -b <arquivo_base> -e <arquivo_ev>\n", argv[0]);
-        return 1;
+// Função para ler um arquivo de pontos de consulta e encontrar os k pontos de
+// recarga mais próximos de todos eles de uma só vez, usando nthreads threads
+void join_points(const char* filename, long k, int nthreads) 
+{
+    // Abre o arquivo para leitura
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o arquivo %s\n", filename);
+        exit(1);
+    }
+
+    // A primeira linha contém o número de pontos de consulta
+    long nq;
+    if (fscanf(file, "%ld", &nq) != 1 || nq < 0) {
+        fprintf(stderr, "Erro: nao foi possivel ler o numero de pontos\n");
+        fclose(file);
+        exit(1);
+    }
+    if (k > nrecharge) {
+        fprintf(stderr, "Número de pontos de recarga solicitados maior que o número de pontos de recarga disponíveis.\n");
+        fclose(file);
+        return;
+    }
+    double* xs = (double*) malloc((nq + 1) * sizeof(double));
+    double* ys = (double*) malloc((nq + 1) * sizeof(double));
+    long i = 0;
+    while (i < nq && fscanf(file, "%lf %lf", &xs[i], &ys[i]) == 2) {
+        i++;
+    }
+    fclose(file);
+    nq = i;
+
+    // Resolve todas as consultas e imprime os resultados na ordem do arquivo
+    Neighbor* result = (Neighbor*) malloc((nq * k + 1) * sizeof(Neighbor));
+    long* found = (long*) malloc((nq + 1) * sizeof(long));
+    join_knn(engine, &base_boundary, xs, ys, nq, k, nthreads, result, found);
+    for (i = 0; validate && i < nq; i++) {
+        validate_knn(xs[i], ys[i], k, NULL, result + i * k, found[i]);
     }
+    for (i = 0; i < nq; i++) {
+        fprintf(output, "C %lf %lf %ld\n", xs[i], ys[i], k);
+        print_closest(result + i * k, found[i]);
+    }
+    free(xs);
+    free(ys);
+    free(result);
+    free(found);
+}
+
+// Função chamada pelo servidor a cada rodada de eventos: confirma os eventos
+// do diário e escreve o relatório de latência, se solicitado por sinal
+void server_commit() 
+{
+    journal_commit();
+    latency_poll();
+}
+
+// Função que atende uma requisição do modo servidor: executa o comando e 
+// escreve a resposta em out
+void serve_command(char* line, FILE* out) 
+{
+    output = out;
+    execute_command(line);
+    output = stdout;
+}
 
-    char *base_file = NULL;
+int main(int argc, char** argv) 
+{	
     char *ev_file = NULL;
+    char *engine_name = NULL;
+    char *socket_path = NULL;
+    char *latency_path = NULL;
+    char *query_path = NULL;
+    char *page_path = NULL;
+    char *split_name = NULL;
+    long page_budget = 1024;
+    long join_k = 1;
+    int ret = 0;
+    nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
 
     // Itera sobre os argumentos da linha de comando
     for (int i = 1; i < argc; i++) {
         // Verifica se o argumento é "-b" e armazena o próximo argumento como base_file
-        if (strcmp(argv[i], "-b") == 0) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
             base_file = argv[++i];
         // Verifica se o argumento é "-e" e armazena o próximo argumento como ev_file
-        } else if (strcmp(argv[i], "-e") == 0) {
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
             ev_file = argv[++i];
+        // Verifica se o argumento é "-i" e armazena o próximo argumento como engine_name
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            engine_name = argv[++i];
+        // Verifica se o argumento é "-s" e armazena o próximo argumento como socket_path
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        // Verifica se o argumento é "-j" e armazena o próximo argumento como journal_path
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        // Verifica se o argumento é "-t" e armazena o próximo argumento como latency_path
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            latency_path = argv[++i];
+        // Verifica se o argumento é "-q" e armazena o próximo argumento como query_path
+        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            query_path = argv[++i];
+        // Verifica se o argumento é "-k" e armazena o próximo argumento como join_k
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            join_k = atol(argv[++i]);
+        // Verifica se o argumento é "-p" e armazena o próximo argumento como nthreads
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            nthreads = atoi(argv[++i]);
+        // Verifica se o argumento é "-d" e armazena o próximo argumento como page_path
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            page_path = argv[++i];
+        // Verifica se o argumento é "-a" e armazena o próximo argumento como split_name
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            split_name = argv[++i];
+        // Verifica se o argumento é "-c" e armazena o próximo argumento como page_budget
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            page_budget = atol(argv[++i]);
+        // Verifica se o argumento é "-z" e ativa a execução em lote
+        } else if (strcmp(argv[i], "-z") == 0) {
+            batch_mode = true;
+        // Verifica se o argumento é "-v" e ativa a validação das consultas
+        } else if (strcmp(argv[i], "-v") == 0) {
+            validate = true;
         }
     }
 
-    // Verifica se os arquivos base_file e ev_file foram fornecidos
-    if (base_file == NULL || ev_file == NULL) {
+    // Verifica se o arquivo base_file e o arquivo ev_file, o socket ou o 
+    // arquivo de consultas foram fornecidos
+    if (base_file == NULL || (ev_file == NULL && socket_path == NULL && query_path == NULL) || join_k < 1) {
         // Imprime mensagem de uso correto do programa
-        fprintf(stderr, "Uso: %s -b <arquivo_base> -e <arquivo_ev>\n", argv[0]);
+        fprintf(stderr, "Uso: %s -b <arquivo_base> -e <arquivo_ev> [-p <threads>] [-i <motor> [-a <divisao>]] [-d <paginas> [-c <KiB>]] [-z] [-v] [-j <diario>] [-t <arquivo>]\n", argv[0]);
+        fprintf(stderr, "     %s -b <arquivo_base> -s <socket> [-p <threads>] [-i <motor> [-a <divisao>]] [-d <paginas> [-c <KiB>]] [-v] [-j <diario>] [-t <arquivo>]\n", argv[0]);
+        fprintf(stderr, "     %s -b <arquivo_base> -q <arquivo_pontos> [-k <n>] [-p <threads>] [-i <motor> [-a <divisao>]] [-d <paginas> [-c <KiB>]] [-v] [-j <diario>]\n", argv[0]);
+        return 1;
+    }
+    output = stdout;
+    latency_install_signal(latency_path);
+
+    // Seleciona o índice espacial
+    engine = spindex_find(engine_name);
+    if (engine == NULL) {
+        fprintf(stderr, "Erro: motor %s desconhecido. Motores disponiveis: ", engine_name);
+        spindex_list(stderr);
         return 1;
     }
 
+    // Configura o modo de divisão dos nós da quadtree
+    if (split_name != NULL) {
+        int mode;
+        if (!strcmp(split_name, "meio")) mode = QUADTREE_SPLIT_MIDPOINT;
+        else if (!strcmp(split_name, "mediana")) mode = QUADTREE_SPLIT_MEDIAN;
+        else if (!strcmp(split_name, "centroide")) mode = QUADTREE_SPLIT_CENTROID;
+        else {
+            fprintf(stderr, "Erro: divisao %s desconhecida. Divisoes disponiveis: meio, mediana, centroide\n", split_name);
+            return 1;
+        }
+        if (engine != &quadtree_index && engine != &auto_index) {
+            fprintf(stderr, "Erro: a opcao -a requer o motor quadtree ou auto\n");
+            return 1;
+        }
+        quadtree_set_split(mode);
+    }
+
+    // Configura a quadtree paginada, cujo pool tem page_budget KiB
+    if (page_path != NULL) {
+        if (engine != &quadtree_index && engine != &auto_index) {
+            fprintf(stderr, "Erro: a opcao -d requer o motor quadtree ou auto\n");
+            return 1;
+        }
+        quadtree_set_paging(page_path, (size_t) page_budget * 1024);
+        latency_track_pages(node_page_stats);
+    }
+
     // Carrega os pontos de recarga a partir do arquivo especificado por base_file
     load_recharge_stations(base_file);
-    // Lê os comandos a partir do arquivo especificado por ev_file
-    read_commands(ev_file);
+    // Recupera o estado dos pontos de recarga a partir do diário
+    if (journal_path != NULL && journal_open(journal_path, apply_journal_event) != 0) {
+        return 1;
+    }
+    if (socket_path != NULL) {
+        // Atende comandos no socket (ou na entrada padrão) até ser encerrado
+        map_enabled = false;
+        ret = !strcmp(socket_path, "-") ? server_run_stdio(serve_command, server_commit)
+                                        : server_run_socket(socket_path, serve_command, server_commit);
+    }
+    else if (query_path != NULL) {
+        // Encontra os vizinhos de todos os pontos do arquivo de consultas
+        join_points(query_path, join_k, nthreads);
+    }
+    else {
+        // Lê os comandos a partir do arquivo especificado por ev_file
+        read_commands(ev_file);
+    }
+
+    // Grava os eventos pendentes no diário e o relatório de latência
+    journal_close();
+    if (latency_path != NULL) {
+        latency_dump_file(latency_path);
+    }
+    if (validate) {
+        fprintf(stderr, "Validacao: %ld consultas, %ld divergencias\n", validated, mismatches);
+    }
 
-    // Destroi a quadtree para liberar os recursos alocados
-    quadtree_destroy();
+    // Destroi o índice espacial e o vetor de pontos de recarga para liberar
+    // os recursos alocados
+    unload_recharge_stations();
 
-    return 0;
+    return ret ? 1 : 0;
 }
@@ -8,9 +8,37 @@ bool boundary_contains(Boundary* bd, double x, double y)
             y >= bd->y_min && y < bd->y_max);
 }
 
-// Função auxiliar que calcula a distância mínima de um ponto (x, y) até os 
-// limites do retângulo (Boundary)
-static double min_dist_to_boundary(Boundary* boundary, double x, double y) {
+Boundary boundary_quadrant(Boundary* bd, int q)
+{
+    // Divide o retângulo no ponto médio
+    return boundary_split(bd, q, (bd->x_min + bd->x_max) / 2, (bd->y_min + bd->y_max) / 2);
+}
+
+int boundary_quadrant_of(Boundary* bd, double x, double y)
+{
+    return boundary_split_of(x, y, (bd->x_min + bd->x_max) / 2, (bd->y_min + bd->y_max) / 2);
+}
+
+Boundary boundary_split(Boundary* bd, int q, double sx, double sy)
+{
+    // Retorna os limites do quadrante solicitado
+    switch (q) {
+    case QUAD_NW: return (Boundary) {bd->x_min, sx, sy, bd->y_max};
+    case QUAD_NE: return (Boundary) {sx, bd->x_max, sy, bd->y_max};
+    case QUAD_SW: return (Boundary) {bd->x_min, sx, bd->y_min, sy};
+    default:      return (Boundary) {sx, bd->x_max, bd->y_min, sy};
+    }
+}
+
+int boundary_split_of(double x, double y, double sx, double sy)
+{
+    // Os quadrantes são semiabertos, assim como em boundary_contains
+    bool east = x >= sx;
+    bool south = y < sy;
+    return (south ? QUAD_SW : QUAD_NW) + (east ? 1 : 0);
+}
+
+double boundary_min_dist(Boundary* boundary, double x, double y) {
     // Calcula a distância no eixo x até o limite mais próximo do retângulo
     double dx = fmax(fmax(boundary->x_min - x, 0), x - boundary->x_max);
     // Calcula a distância no eixo y até o limite mais próximo do retângulo
@@ -21,8 +49,35 @@ static double min_dist_to_boundary(Boundary* boundary, double x, double y) {
 
 bool can_contain_closer_point(Boundary* boundary, double x, double y, double max_dist) {
     // Calcula a distância mínima do ponto (x, y) até os limites do retângulo
-    double min_dist = min_dist_to_boundary(boundary, x, y);
+    double min_dist = boundary_min_dist(boundary, x, y);
     // Retorna verdadeiro se a distância mínima for menor que a distância
     // máxima permitida
     return min_dist < max_dist;
-}
\ No newline at end of file
+}
+
+bool boundary_hits_segment(const Boundary* bd, double x0, double y0, double x1, double y1) {
+    // Recorta o segmento pelos quatro lados do retângulo fechado (algoritmo
+    // de Liang-Barsky): o segmento toca o retângulo se restar algum trecho
+    double dx = x1 - x0;
+    double dy = y1 - y0;
+    double p[4] = {-dx, dx, -dy, dy};
+    double q[4] = {x0 - bd->x_min, bd->x_max - x0, y0 - bd->y_min, bd->y_max - y0};
+    double t0 = 0, t1 = 1;
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0) {
+            // Segmento paralelo ao lado e fora dele
+            if (q[i] < 0) return false;
+            continue;
+        }
+        double t = q[i] / p[i];
+        if (p[i] < 0) {
+            if (t > t1) return false;
+            if (t > t0) t0 = t;
+        }
+        else {
+            if (t < t0) return false;
+            if (t < t1) t1 = t;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,189 @@
+#include "filter.h"
+
+// Número de campos textuais codificados em dicionários
+#define FILTER_NTEXT 3
+
+// Variáveis encapsuladas que mantêm os dicionários
+char** dictvals[FILTER_NTEXT] = {NULL}; // Valores distintos de cada campo, ordenados
+long dictsz[FILTER_NTEXT] = {0}; // Número de valores de cada campo
+int32_t* stationcodes = NULL; // Códigos dos campos de cada ponto de recarga
+long numcoded = 0; // Número de pontos de recarga codificados
+Arena dictarena = EMPTYARENA; // Strings dos dicionários
+
+// Campo usado pela função de comparação durante a construção
+static FilterField sortfield = FILTER_NONE;
+
+// Função auxiliar que retorna o valor textual do campo f do ponto id
+static const char* filter_value(long id, FilterField f) {
+    Item* it = station_get(id);
+    switch (f) {
+    case FILTER_REGIO: return it->nome_regio;
+    case FILTER_BAIRRO: return it->nome_bairr;
+    case FILTER_TIPO: return it->sigla_tipo;
+    default: return "";
+    }
+}
+
+// Função de comparação que ordena identificadores pelo valor de sortfield
+static int cmpvalue(const void* a, const void* b) {
+    return strcmp(filter_value(*(const long*) a, sortfield), filter_value(*(const long*) b, sortfield));
+}
+
+// Primeira palavra e número de palavras do resumo de cada campo textual
+static const int summaryfirst[FILTER_NTEXT] = {0, FILTER_REGIOWORDS, FILTER_REGIOWORDS + FILTER_BAIRROWORDS};
+static const int summarywords[FILTER_NTEXT] = {FILTER_REGIOWORDS, FILTER_BAIRROWORDS, FILTER_TIPOWORDS};
+
+// Função auxiliar que retorna a posição, em attrs, da palavra que contém o
+// bit do código no campo textual t, e armazena esse bit em bit
+static int filter_word(int t, int code, uint64_t* bit) {
+    int pos = code % (64 * summarywords[t]);
+    *bit = (uint64_t) 1 << (pos % 64);
+    return summaryfirst[t] + pos / 64;
+}
+
+void filter_build() {
+    filter_destroy();
+    long n = station_count();
+    stationcodes = (int32_t*) malloc((n + 1) * FILTER_NTEXT * sizeof(int32_t));
+    long* ids = (long*) malloc((n + 1) * sizeof(long));
+    if (stationcodes == NULL || ids == NULL) {
+        fprintf(stderr,"filter_build: could not allocate codes\n");
+        free(ids);
+        filter_destroy();
+        return;
+    }
+    numcoded = n;
+
+    for (int t = 0; t < FILTER_NTEXT; t++) {
+        // Ordena os pontos pelo valor do campo e atribui códigos crescentes
+        // a cada valor distinto, de modo que o dicionário fica ordenado
+        sortfield = FILTER_REGIO + t;
+        for (long i = 0; i < n; i++) {
+            ids[i] = i;
+        }
+        qsort(ids, n, sizeof(long), cmpvalue);
+        dictvals[t] = (char**) malloc((n + 1) * sizeof(char*));
+        dictsz[t] = 0;
+        for (long i = 0; i < n; i++) {
+            const char* v = filter_value(ids[i], sortfield);
+            if (dictsz[t] == 0 || strcmp(dictvals[t][dictsz[t] - 1], v)) {
+                dictvals[t][dictsz[t]++] = arena_strdup(&dictarena, v);
+            }
+            stationcodes[ids[i] * FILTER_NTEXT + t] = dictsz[t] - 1;
+        }
+        // Reduz o dicionário ao número de valores distintos
+        dictvals[t] = (char**) realloc(dictvals[t], (dictsz[t] + 1) * sizeof(char*));
+    }
+    free(ids);
+}
+
+void filter_destroy() {
+    for (int t = 0; t < FILTER_NTEXT; t++) {
+        free(dictvals[t]);
+        dictvals[t] = NULL;
+        dictsz[t] = 0;
+    }
+    free(stationcodes);
+    arena_release(&dictarena);
+    stationcodes = NULL;
+    numcoded = 0;
+}
+
+size_t filter_memory() {
+    size_t bytes = numcoded * FILTER_NTEXT * sizeof(int32_t) + arena_memory(&dictarena);
+    for (int t = 0; t < FILTER_NTEXT; t++) {
+        if (dictvals[t] != NULL) bytes += (dictsz[t] + 1) * sizeof(char*);
+    }
+    return bytes;
+}
+
+// Função auxiliar que busca o valor no dicionário do campo textual t e 
+// retorna seu código, ou -1 se não existir
+static int filter_lookup(int t, const char* value) {
+    long lo = 0, hi = dictsz[t] - 1;
+    while (lo <= hi) {
+        long mid = lo + (hi - lo) / 2;
+        int c = strcmp(dictvals[t][mid], value);
+        if (c == 0) return (int) mid;
+        if (c < 0) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+int filter_parse(Filter* f, const char* name, const char* value) {
+    static const char* names[FILTER_NFIELDS] = {"", "regiao", "bairro", "tipo", "cep"};
+    f->field = FILTER_NONE;
+    f->code = -1;
+    f->cep_min = 0;
+    f->cep_max = -1;
+    for (int i = FILTER_REGIO; i < FILTER_NFIELDS; i++) {
+        if (!strcmp(names[i], name)) f->field = i;
+    }
+    if (f->field == FILTER_NONE) return -1;
+
+    if (f->field == FILTER_CEP) {
+        // O prefixo de um CEP de 8 dígitos corresponde a uma faixa contígua
+        long len = strlen(value);
+        if (len == 0 || len > 8 || strspn(value, "0123456789") != (size_t) len) return -1;
+        int scale = 1;
+        for (long i = len; i < 8; i++) scale *= 10;
+        f->cep_min = atoi(value) * scale;
+        f->cep_max = f->cep_min + scale - 1;
+        return 0;
+    }
+    f->code = filter_lookup(f->field - FILTER_REGIO, value);
+    return 0;
+}
+
+bool filter_match(const Filter* f, long id) {
+    if (f == NULL || f->field == FILTER_NONE) return true;
+    if (f->field == FILTER_CEP) {
+        int cep = station_get(id)->cep;
+        return cep >= f->cep_min && cep <= f->cep_max;
+    }
+    return id < numcoded && stationcodes[id * FILTER_NTEXT + f->field - FILTER_REGIO] == f->code;
+}
+
+void filter_prefetch(const Filter* f, long id) {
+    if (f == NULL || f->field == FILTER_NONE || f->field == FILTER_CEP || id >= numcoded) return;
+    __builtin_prefetch(&stationcodes[id * FILTER_NTEXT + f->field - FILTER_REGIO]);
+}
+
+bool filter_may_match(const Filter* f, const AttrSummary* s) {
+    if (f == NULL || f->field == FILTER_NONE) return true;
+    if (f->field == FILTER_CEP) {
+        return s->cep_min <= f->cep_max && s->cep_max >= f->cep_min;
+    }
+    if (f->code < 0) return false;
+    uint64_t bit;
+    int w = filter_word(f->field - FILTER_REGIO, f->code, &bit);
+    return (s->attrs[w] & bit) != 0;
+}
+
+AttrSummary filter_summary(long id) {
+    AttrSummary s = EMPTYSUMMARY;
+    if (id < numcoded) {
+        for (int t = 0; t < FILTER_NTEXT; t++) {
+            uint64_t bit;
+            int w = filter_word(t, stationcodes[id * FILTER_NTEXT + t], &bit);
+            s.attrs[w] |= bit;
+        }
+    }
+    else {
+        // Um ponto ainda não codificado pode satisfazer qualquer filtro
+        for (int w = 0; w < FILTER_SUMMARYWORDS; w++) {
+            s.attrs[w] = ~(uint64_t) 0;
+        }
+    }
+    s.cep_min = s.cep_max = station_get(id)->cep;
+    return s;
+}
+
+void filter_summary_merge(AttrSummary* s, const AttrSummary* other) {
+    for (int w = 0; w < FILTER_SUMMARYWORDS; w++) {
+        s->attrs[w] |= other->attrs[w];
+    }
+    if (other->cep_min < s->cep_min) s->cep_min = other->cep_min;
+    if (other->cep_max > s->cep_max) s->cep_max = other->cep_max;
+}
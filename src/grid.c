@@ -0,0 +1,210 @@
+#include "grid.h"
+
+// Variáveis encapsuladas que mantêm a grade. As células são armazenadas de
+// forma compacta: os pontos da célula c estão em 
+// gridpoints[cellstart[c] .. cellstart[c + 1])
+Boundary gridbd = INVALIDBOUNDARY; // Limites da grade
+double cellsz = 0; // Lado de cada célula
+long gridnx = 0; // Número de colunas
+long gridny = 0; // Número de linhas
+long* cellstart = NULL; // Início de cada célula em gridpoints
+GridPoint* gridpoints = NULL; // Pontos agrupados por célula
+
+// Funções privadas
+static long grid_col(double x);
+static long grid_row(double y);
+static void grid_visit_cell(long i, long j, double x, double y, long k, const Filter* filter, Heap* heap);
+static int cmpknn(const void* a, const void* b);
+
+// Retorna a coluna da célula que contém a coordenada x, limitada à grade
+static long grid_col(double x) {
+    long i = (long) floor((x - gridbd.x_min) / cellsz);
+    if (i < 0) return 0;
+    if (i >= gridnx) return gridnx - 1;
+    return i;
+}
+
+// Retorna a linha da célula que contém a coordenada y, limitada à grade
+static long grid_row(double y) {
+    long j = (long) floor((y - gridbd.y_min) / cellsz);
+    if (j < 0) return 0;
+    if (j >= gridny) return gridny - 1;
+    return j;
+}
+
+void grid_build(Boundary bd) {
+    long n = station_count();
+
+    // Estende os limites para conter todos os pontos de recarga
+    gridbd = bd;
+    for (long p = 0; p < n; p++) {
+        Item* it = station_get(p);
+        gridbd.x_min = fmin(gridbd.x_min, it->x);
+        gridbd.x_max = fmax(gridbd.x_max, it->x);
+        gridbd.y_min = fmin(gridbd.y_min, it->y);
+        gridbd.y_max = fmax(gridbd.y_max, it->y);
+    }
+
+    // Define o lado das células para obter, em média, GRID_POINTS_PER_CELL
+    // pontos por célula
+    double width = gridbd.x_max - gridbd.x_min;
+    double height = gridbd.y_max - gridbd.y_min;
+    long ncells = n / GRID_POINTS_PER_CELL;
+    if (ncells < 1) ncells = 1;
+    cellsz = sqrt(width * height / ncells);
+    if (!(cellsz > 0)) cellsz = fmax(fmax(width, height), 1.0);
+    gridnx = (long) ceil(width / cellsz);
+    gridny = (long) ceil(height / cellsz);
+    if (gridnx < 1) gridnx = 1;
+    if (gridny < 1) gridny = 1;
+
+    // Conta os pontos de cada célula e calcula o início de cada uma
+    cellstart = (long*) calloc(gridnx * gridny + 1, sizeof(long));
+    gridpoints = (GridPoint*) malloc((n > 0 ? n : 1) * sizeof(GridPoint));
+    if (cellstart == NULL || gridpoints == NULL) {
+        fprintf(stderr,"grid_build: could not allocate grid\n");
+        grid_destroy();
+        return;
+    }
+    for (long p = 0; p < n; p++) {
+        Item* it = station_get(p);
+        cellstart[grid_row(it->y) * gridnx + grid_col(it->x) + 1]++;
+    }
+    for (long c = 0; c < gridnx * gridny; c++) {
+        cellstart[c + 1] += cellstart[c];
+    }
+
+    // Distribui os pontos nas células, usando um vetor auxiliar de posições
+    long* fill = (long*) malloc(gridnx * gridny * sizeof(long));
+    memcpy(fill, cellstart, gridnx * gridny * sizeof(long));
+    for (long p = 0; p < n; p++) {
+        Item* it = station_get(p);
+        long c = grid_row(it->y) * gridnx + grid_col(it->x);
+        gridpoints[fill[c]++] = (GridPoint) {it->x, it->y, (int32_t) p};
+    }
+    free(fill);
+}
+
+void grid_destroy() {
+    free(cellstart);
+    free(gridpoints);
+    cellstart = NULL;
+    gridpoints = NULL;
+    gridbd = INVALIDBOUNDARY;
+    gridnx = gridny = 0;
+    cellsz = 0;
+}
+
+size_t grid_memory() {
+    if (cellstart == NULL) return 0;
+    return (gridnx * gridny + 1) * sizeof(long) + cellstart[gridnx * gridny] * sizeof(GridPoint);
+}
+
+long grid_search(char* idend, double x, double y) {
+    // Verifica se a grade está vazia
+    if (cellstart == NULL) {
+        fprintf(stderr, "grid_search: grid empty\n");
+        return INVALIDSTATION;
+    }
+    // Percorre apenas a célula que contém as coordenadas
+    long c = grid_row(y) * gridnx + grid_col(x);
+    for (long p = cellstart[c]; p < cellstart[c + 1]; p++) {
+        if (!strcmp(station_get(gridpoints[p].key)->idend, idend)) {
+            return gridpoints[p].key;
+        }
+    }
+    return INVALIDSTATION;
+}
+
+// Função auxiliar que considera os pontos ativos da célula (i, j) que 
+// satisfazem o filtro para o heap dos k vizinhos mais próximos
+static void grid_visit_cell(long i, long j, double x, double y, long k, const Filter* filter, Heap* heap) {
+    long c = j * gridnx + i;
+    for (long p = cellstart[c]; p < cellstart[c + 1]; p++) {
+        GridPoint* gp = &gridpoints[p];
+        if (!station_is_active(gp->key) || !filter_match(filter, gp->key)) continue;
+        double dist = sqrt(pow(gp->x - x, 2) + pow(gp->y - y, 2));
+        if (heap->size < k) {
+            heap_push(heap, (Neighbor) {gp->key, dist});
+        }
+        else if (dist < heap->neighbors[0].dist) {
+            heap_pop(heap);
+            heap_push(heap, (Neighbor) {gp->key, dist});
+        }
+    }
+}
+
+// Função de comparação para o KNN
+static int cmpknn(const void* a, const void* b) {
+    Neighbor* k1 = (Neighbor*) a;
+    Neighbor* k2 = (Neighbor*) b;
+    // Compara as distâncias dos vizinhos
+    if (k1->dist > k2->dist) return 1;
+    else if (k1->dist < k2->dist) return -1;
+    else return 0;
+}
+
+long grid_knn(double x, double y, long k, const Filter* filter, Neighbor* result) {
+    // Verifica se a grade está vazia
+    if (cellstart == NULL) {
+        fprintf(stderr,"grid_knn: grid empty\n");
+        return 0;
+    }
+    Heap* heap = heap_initialize(k);
+    long cx = grid_col(x);
+    long cy = grid_row(y);
+
+    for (long r = 0; ; r++) {
+        // Visita as células do anel r, isto é, aquelas a distância de 
+        // Chebyshev r da célula (cx, cy), limitadas à grade
+        long i0 = cx - r, i1 = cx + r, j0 = cy - r, j1 = cy + r;
+        for (long i = (i0 < 0 ? 0 : i0); i <= i1 && i < gridnx; i++) {
+            if (j0 >= 0) grid_visit_cell(i, j0, x, y, k, filter, heap);
+            if (r > 0 && j1 < gridny) grid_visit_cell(i, j1, x, y, k, filter, heap);
+        }
+        for (long j = (j0 + 1 < 0 ? 0 : j0 + 1); j < j1 && j < gridny; j++) {
+            if (r > 0 && i0 >= 0) grid_visit_cell(i0, j, x, y, k, filter, heap);
+            if (r > 0 && i1 < gridnx) grid_visit_cell(i1, j, x, y, k, filter, heap);
+        }
+
+        // Calcula a menor distância de (x, y) até uma célula fora dos anéis já
+        // visitados. Lados que já alcançaram a borda da grade não têm mais 
+        // células além deles
+        double bound = INFINITY;
+        if (i0 > 0) bound = fmin(bound, x - (gridbd.x_min + i0 * cellsz));
+        if (i1 < gridnx - 1) bound = fmin(bound, gridbd.x_min + (i1 + 1) * cellsz - x);
+        if (j0 > 0) bound = fmin(bound, y - (gridbd.y_min + j0 * cellsz));
+        if (j1 < gridny - 1) bound = fmin(bound, gridbd.y_min + (j1 + 1) * cellsz - y);
+
+        // Para quando toda a grade foi visitada ou quando nenhuma célula 
+        // restante pode conter um ponto mais próximo que o k-ésimo
+        if (bound == INFINITY) break;
+        if (heap->size == k && heap->neighbors[0].dist <= bound) break;
+    }
+
+    // Ordena os vizinhos encontrados pela distância e os copia para o 
+    // array de resultados
+    qsort(heap->neighbors, heap->size, sizeof(Neighbor), cmpknn);
+    memcpy(result, heap->neighbors, heap->size * sizeof(Neighbor));
+    long found = heap->size;
+    heap_destroy(heap);
+    return found;
+}
+
+const SpatialIndex grid_index = {
+    "grid",
+    grid_build,
+    grid_destroy,
+    NULL,
+    grid_search,
+    grid_knn,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    grid_memory
+};
@@ -0,0 +1,107 @@
+#include "join.h"
+
+// Estado compartilhado pelas threads de uma junção
+typedef struct {
+    const SpatialIndex* ix; // Motor usado nas consultas
+    const double* xs;   // Coordenadas x das consultas, em ordem espacial
+    const double* ys;   // Coordenadas y das consultas, em ordem espacial
+    long nq;            // Número de consultas
+    long k;             // Número de vizinhos por consulta
+    long nchunks;       // Número de blocos
+    atomic_long next;   // Próximo bloco a ser processado
+    Neighbor* result;   // Vizinhos de cada consulta, em ordem espacial
+    long* found;        // Número de vizinhos de cada consulta
+} JoinTask;
+
+// Consulta e sua posição original, para a ordenação espacial
+typedef struct {
+    uint32_t code;      // Código de Morton das coordenadas
+    long index;         // Posição da consulta na entrada
+} JoinOrder;
+
+// Função de comparação que ordena as consultas pelo código de Morton, 
+// mantendo a ordem de entrada em caso de empate
+static int cmp_order(const void* a, const void* b) {
+    const JoinOrder* o1 = (const JoinOrder*) a;
+    const JoinOrder* o2 = (const JoinOrder*) b;
+    if (o1->code != o2->code) return o1->code > o2->code ? 1 : -1;
+    return (o1->index > o2->index) - (o1->index < o2->index);
+}
+
+// Função auxiliar que resolve as consultas [lo, hi) de uma vez
+static void join_chunk(JoinTask* t, long lo, long hi) {
+    if (t->ix->knn_join != NULL) {
+        t->ix->knn_join(t->xs + lo, t->ys + lo, hi - lo, t->k, t->result + lo * t->k, t->found + lo);
+        return;
+    }
+    for (long i = lo; i < hi; i++) {
+        t->found[i] = t->ix->knn(t->xs[i], t->ys[i], t->k, NULL, t->result + i * t->k);
+    }
+}
+
+// Função executada por cada thread: processa blocos até que não restem mais
+static void* join_worker(void* arg) {
+    JoinTask* t = (JoinTask*) arg;
+    long c;
+    while ((c = atomic_fetch_add(&t->next, 1)) < t->nchunks) {
+        long lo = c * t->nq / t->nchunks;
+        long hi = (c + 1) * t->nq / t->nchunks;
+        join_chunk(t, lo, hi);
+    }
+    return NULL;
+}
+
+void join_knn(const SpatialIndex* ix, Boundary* bd, const double* xs, const double* ys, long nq, long k,
+              int nthreads, Neighbor* result, long* found) {
+    if (nq <= 0) return;
+    if (nthreads < 1) nthreads = 1;
+
+    // Ordena as consultas pelo código de Morton, de modo que cada bloco 
+    // contíguo cubra uma região compacta da cidade
+    JoinOrder* order = (JoinOrder*) malloc(nq * sizeof(JoinOrder));
+    double* sx = (double*) malloc(nq * sizeof(double));
+    double* sy = (double*) malloc(nq * sizeof(double));
+    Neighbor* sresult = (Neighbor*) malloc((nq * k + 1) * sizeof(Neighbor));
+    long* sfound = (long*) malloc(nq * sizeof(long));
+    pthread_t* threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+    if (order == NULL || sx == NULL || sy == NULL || sresult == NULL || sfound == NULL || threads == NULL) {
+        fprintf(stderr,"join_knn: could not allocate join\n");
+        free(order); free(sx); free(sy); free(sresult); free(sfound); free(threads);
+        return;
+    }
+    for (long i = 0; i < nq; i++) {
+        order[i] = (JoinOrder) {morton_encode(bd, xs[i], ys[i]), i};
+    }
+    qsort(order, nq, sizeof(JoinOrder), cmp_order);
+    for (long i = 0; i < nq; i++) {
+        sx[i] = xs[order[i].index];
+        sy[i] = ys[order[i].index];
+    }
+
+    // Distribui os blocos entre as threads
+    JoinTask task = {ix, sx, sy, nq, k, 0, 0, sresult, sfound};
+    task.nchunks = (long) nthreads * JOIN_CHUNKS_PER_THREAD;
+    if (task.nchunks > nq) task.nchunks = nq;
+    atomic_init(&task.next, 0);
+    int started = 0;
+    for (int i = 1; i < nthreads; i++) {
+        if (pthread_create(&threads[started], NULL, join_worker, &task) != 0) {
+            fprintf(stderr,"join_knn: could not create thread\n");
+            break;
+        }
+        started++;
+    }
+    // A thread atual também processa blocos
+    join_worker(&task);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Devolve os resultados à ordem de entrada
+    for (long i = 0; i < nq; i++) {
+        long dst = order[i].index;
+        found[dst] = sfound[i];
+        memcpy(result + dst * k, sresult + i * k, sfound[i] * sizeof(Neighbor));
+    }
+    free(order); free(sx); free(sy); free(sresult); free(sfound); free(threads);
+}
@@ -0,0 +1,259 @@
+#include "journal.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libgen.h>
+
+// Formato do diário: um cabeçalho (JournalHeader) seguido de registros de
+// tamanho fixo (JournalRecord), apenas acrescentados ao fim do arquivo. O 
+// snapshot tem o mesmo cabeçalho, seguido de um bitmap com o estado de 
+// atividade de cada ponto de recarga
+#define JOURNAL_MAGIC 0x4A554942u  // "BIUJ"
+#define SNAPSHOT_MAGIC 0x53554942u // "BIUS"
+#define JOURNAL_VERSION 1
+
+typedef struct {
+    uint32_t magic;         // Identificação do tipo de arquivo
+    uint32_t version;       // Versão do formato
+    uint32_t nstations;     // Número de pontos de recarga da base
+    uint32_t basehash;      // Hash dos identificadores da base
+} JournalHeader;
+
+typedef struct {
+    uint32_t id;            // Índice do ponto de recarga
+    uint8_t op;             // Tipo de evento
+    uint8_t reserved[3];    // Reservado (zero)
+} JournalRecord;
+
+// Variáveis encapsuladas que mantêm o diário aberto
+int journalfd = -1; // Descritor do arquivo do diário
+char* journalpath = NULL; // Caminho do diário
+JournalRecord journalbuf[JOURNAL_GROUP]; // Eventos ainda não gravados
+long journalpending = 0; // Número de eventos em journalbuf
+long journalrecords = 0; // Número de eventos gravados desde o checkpoint
+
+// Funções privadas
+static uint32_t journal_basehash();
+static JournalHeader journal_header(uint32_t magic);
+static bool journal_header_valid(JournalHeader* h, uint32_t magic);
+static char* journal_snappath(const char* suffix);
+static bool write_all(int fd, const void* data, size_t len);
+static bool journal_syncdir(const char* path);
+static long journal_load_snapshot(journal_apply apply);
+
+// Calcula um hash (FNV-1a) dos identificadores dos pontos de recarga, para 
+// garantir que o diário seja reaplicado sobre a mesma base
+static uint32_t journal_basehash() {
+    uint32_t h = 2166136261u;
+    for (long i = 0; i < station_count(); i++) {
+        for (char* c = station_get(i)->idend; *c; c++) {
+            h = (h ^ (uint8_t) *c) * 16777619u;
+        }
+        h = (h ^ ';') * 16777619u;
+    }
+    return h;
+}
+
+static JournalHeader journal_header(uint32_t magic) {
+    return (JournalHeader) {magic, JOURNAL_VERSION, (uint32_t) station_count(), journal_basehash()};
+}
+
+static bool journal_header_valid(JournalHeader* h, uint32_t magic) {
+    JournalHeader expected = journal_header(magic);
+    return !memcmp(h, &expected, sizeof(JournalHeader));
+}
+
+// Retorna o caminho do diário acrescido do sufixo (alocado com malloc)
+static char* journal_snappath(const char* suffix) {
+    char* p = malloc(strlen(journalpath) + strlen(suffix) + 1);
+    strcpy(p, journalpath);
+    strcat(p, suffix);
+    return p;
+}
+
+// Grava em disco o diretório que contém o arquivo path, para que uma 
+// renomeação feita nele sobreviva a uma queda do sistema
+static bool journal_syncdir(const char* path) {
+    char* copy = strdup(path);
+    if (copy == NULL) return false;
+    int fd = open(dirname(copy), O_RDONLY | O_DIRECTORY);
+    free(copy);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+static bool write_all(int fd, const void* data, size_t len) {
+    const char* p = data;
+    while (len > 0) {
+        ssize_t w = write(fd, p, len);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        len -= w;
+    }
+    return true;
+}
+
+// Reaplica o snapshot, se existir. Retorna o número de pontos cujo estado foi
+// alterado ou -1 se o snapshot não corresponder à base
+static long journal_load_snapshot(journal_apply apply) {
+    char* snappath = journal_snappath(".snap");
+    FILE* f = fopen(snappath, "rb");
+    free(snappath);
+    if (f == NULL) return 0;
+
+    JournalHeader h;
+    if (fread(&h, sizeof(h), 1, f) != 1 || !journal_header_valid(&h, SNAPSHOT_MAGIC)) {
+        fclose(f);
+        return -1;
+    }
+    long n = station_count();
+    long changed = 0;
+    uint8_t* bits = malloc((n + 7) / 8 + 1);
+    if (fread(bits, 1, (n + 7) / 8, f) != (size_t) ((n + 7) / 8)) {
+        free(bits);
+        fclose(f);
+        return -1;
+    }
+    for (long i = 0; i < n; i++) {
+        bool ativo = (bits[i / 8] >> (i % 8)) & 1;
+        if (station_is_active(i) != ativo) {
+            apply(i, ativo);
+            changed++;
+        }
+    }
+    free(bits);
+    fclose(f);
+    return changed;
+}
+
+int journal_open(const char* path, journal_apply apply) {
+    journalpath = strdup(path);
+    journalpending = 0;
+    journalrecords = 0;
+
+    // Reaplica primeiro o snapshot
+    if (journal_load_snapshot(apply) < 0) {
+        fprintf(stderr, "Erro: snapshot do diario %s nao corresponde a base\n", path);
+        return -1;
+    }
+
+    journalfd = open(path, O_RDWR | O_CREAT, 0644);
+    if (journalfd < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o diario %s\n", path);
+        return -1;
+    }
+
+    // Um diário vazio recebe o cabeçalho; um existente é validado e seus 
+    // eventos são reaplicados em ordem
+    JournalHeader h;
+    ssize_t r = read(journalfd, &h, sizeof(h));
+    if (r == 0) {
+        h = journal_header(JOURNAL_MAGIC);
+        if (!write_all(journalfd, &h, sizeof(h)) || fdatasync(journalfd) < 0) {
+            fprintf(stderr, "Erro: nao foi possivel escrever o diario %s\n", path);
+            return -1;
+        }
+        return 0;
+    }
+    if (r != sizeof(h) || !journal_header_valid(&h, JOURNAL_MAGIC)) {
+        fprintf(stderr, "Erro: diario %s nao corresponde a base\n", path);
+        return -1;
+    }
+    JournalRecord rec;
+    while (read(journalfd, &rec, sizeof(rec)) == sizeof(rec)) {
+        if (rec.id >= (uint32_t) station_count()) break;
+        if (rec.op == JOURNAL_ACTIVATE || rec.op == JOURNAL_DEACTIVATE) {
+            apply(rec.id, rec.op == JOURNAL_ACTIVATE);
+        }
+        journalrecords++;
+    }
+
+    // Descarta um eventual registro incompleto no fim (gravação interrompida)
+    off_t end = sizeof(JournalHeader) + journalrecords * sizeof(JournalRecord);
+    if (ftruncate(journalfd, end) < 0 || lseek(journalfd, end, SEEK_SET) < 0) {
+        fprintf(stderr, "Erro: nao foi possivel posicionar o diario %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+void journal_append(int op, long id) {
+    if (journalfd < 0) return;
+    if (journalpending == JOURNAL_GROUP) {
+        journal_commit();
+    }
+    journalbuf[journalpending++] = (JournalRecord) {(uint32_t) id, (uint8_t) op, {0, 0, 0}};
+}
+
+void journal_commit() {
+    if (journalfd < 0 || journalpending == 0) return;
+
+    // Grava o grupo inteiro com uma única sincronização
+    if (!write_all(journalfd, journalbuf, journalpending * sizeof(JournalRecord)) ||
+        fdatasync(journalfd) < 0) {
+        fprintf(stderr, "journal_commit: could not write journal\n");
+        return;
+    }
+    journalrecords += journalpending;
+    journalpending = 0;
+
+    // Mantém o diário curto
+    if (journalrecords >= JOURNAL_CHECKPOINT) {
+        journal_checkpoint();
+    }
+}
+
+void journal_checkpoint() {
+    if (journalfd < 0) return;
+    // Os eventos pendentes já estão refletidos no estado dos pontos de 
+    // recarga e serão cobertos pelo snapshot
+    journalpending = 0;
+
+    // Grava o snapshot em um arquivo temporário e o renomeia, para que um 
+    // snapshot incompleto nunca substitua o anterior
+    char* snappath = journal_snappath(".snap");
+    char* tmppath = journal_snappath(".snap.tmp");
+    long n = station_count();
+    uint8_t* bits = calloc((n + 7) / 8 + 1, 1);
+    for (long i = 0; i < n; i++) {
+        if (station_is_active(i)) bits[i / 8] |= 1 << (i % 8);
+    }
+    JournalHeader h = journal_header(SNAPSHOT_MAGIC);
+    int fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && write_all(fd, &h, sizeof(h)) && write_all(fd, bits, (n + 7) / 8) &&
+              fsync(fd) == 0;
+    if (fd >= 0) close(fd);
+    // A renomeação só é durável depois que o diretório é gravado; antes 
+    // disso, o diário ainda não pode ser esvaziado
+    ok = ok && rename(tmppath, snappath) == 0 && journal_syncdir(snappath);
+    free(bits);
+    free(snappath);
+    free(tmppath);
+    if (!ok) {
+        fprintf(stderr, "journal_checkpoint: could not write snapshot\n");
+        return;
+    }
+
+    // Com o snapshot gravado, o diário pode ser esvaziado
+    if (ftruncate(journalfd, sizeof(JournalHeader)) < 0 ||
+        lseek(journalfd, sizeof(JournalHeader), SEEK_SET) < 0 || fdatasync(journalfd) < 0) {
+        fprintf(stderr, "journal_checkpoint: could not truncate journal\n");
+        return;
+    }
+    journalrecords = 0;
+}
+
+void journal_close() {
+    if (journalfd < 0) return;
+    journal_commit();
+    close(journalfd);
+    journalfd = -1;
+    free(journalpath);
+    journalpath = NULL;
+}
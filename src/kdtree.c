@@ -0,0 +1,216 @@
+#include "kdtree.h"
+
+// Variáveis encapsuladas que mantêm o vetor da k-d tree
+KdNode* kdvet = NULL; // Vetor de nós, em ordem de árvore implícita
+long kdvetsz = 0; // Número de nós
+
+// Funções privadas
+static double kd_coord(KdNode* node, int axis);
+static void kd_swap(KdNode* a, KdNode* b);
+static void kd_select(long lo, long hi, long nth, int axis);
+static void kdtree_build_rec(long lo, long hi);
+static long kdtree_search_rec(long lo, long hi, char* idend, double x, double y);
+static void kdtree_knn_rec(long lo, long hi, double x, double y, long k, const Filter* filter, Heap* heap);
+static int cmpknn(const void* a, const void* b);
+
+// Retorna a coordenada do nó no eixo especificado
+static double kd_coord(KdNode* node, int axis) {
+    return axis == 0 ? node->x : node->y;
+}
+
+static void kd_swap(KdNode* a, KdNode* b) {
+    KdNode temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+// Seleção (quickselect) que posiciona em nth o elemento que estaria nessa 
+// posição se [lo, hi) estivesse ordenado pelo eixo, com os menores ou iguais
+// antes e os maiores ou iguais depois. A partição em três faixas (menores,
+// iguais e maiores que o pivô) mantém a seleção linear mesmo com muitas
+// coordenadas repetidas
+static void kd_select(long lo, long hi, long nth, int axis) {
+    while (hi - lo > 1) {
+        // Usa o elemento do meio como pivô e particiona o intervalo em 
+        // [lo, lt) < pivô, [lt, gt) == pivô e [gt, hi) > pivô
+        double pivot = kd_coord(&kdvet[lo + (hi - lo) / 2], axis);
+        long lt = lo, i = lo, gt = hi;
+        while (i < gt) {
+            double c = kd_coord(&kdvet[i], axis);
+            if (c < pivot) kd_swap(&kdvet[lt++], &kdvet[i++]);
+            else if (c > pivot) kd_swap(&kdvet[i], &kdvet[--gt]);
+            else i++;
+        }
+        // Termina se a posição desejada está na faixa dos iguais; senão,
+        // continua apenas no lado que a contém
+        if (nth < lt) hi = lt;
+        else if (nth >= gt) lo = gt;
+        else return;
+    }
+}
+
+// Função auxiliar recursiva que constrói a subárvore do intervalo [lo, hi)
+static void kdtree_build_rec(long lo, long hi) {
+    if (hi - lo <= 0) return;
+
+    // Escolhe o eixo de maior amplitude no intervalo
+    double x_min = INFINITY, x_max = -INFINITY;
+    double y_min = INFINITY, y_max = -INFINITY;
+    for (long i = lo; i < hi; i++) {
+        x_min = fmin(x_min, kdvet[i].x);
+        x_max = fmax(x_max, kdvet[i].x);
+        y_min = fmin(y_min, kdvet[i].y);
+        y_max = fmax(y_max, kdvet[i].y);
+    }
+    int axis = (x_max - x_min >= y_max - y_min) ? 0 : 1;
+
+    // Posiciona a mediana no meio do intervalo e constrói as subárvores
+    long mid = lo + (hi - lo) / 2;
+    kd_select(lo, hi, mid, axis);
+    kdvet[mid].axis = axis;
+    kdtree_build_rec(lo, mid);
+    kdtree_build_rec(mid + 1, hi);
+}
+
+void kdtree_build(Boundary bd) {
+    (void) bd; // Os limites da k-d tree são definidos pelos próprios pontos
+    kdvetsz = station_count();
+    kdvet = (KdNode*) malloc(kdvetsz * sizeof(KdNode));
+    if (kdvet == NULL) {
+        fprintf(stderr,"kdtree_build: could not allocate kdvet\n");
+        kdvetsz = 0;
+        return;
+    }
+    // Copia as coordenadas dos pontos de recarga para o vetor compacto
+    for (long i = 0; i < kdvetsz; i++) {
+        Item* it = station_get(i);
+        kdvet[i] = (KdNode) {it->x, it->y, (int32_t) i, 0};
+    }
+    kdtree_build_rec(0, kdvetsz);
+}
+
+void kdtree_destroy() {
+    free(kdvet);
+    kdvet = NULL;
+    kdvetsz = 0;
+}
+
+size_t kdtree_memory() {
+    return kdvetsz * sizeof(KdNode);
+}
+
+// Função auxiliar recursiva para buscar um ponto de recarga pelo 
+// identificador no intervalo [lo, hi)
+static long kdtree_search_rec(long lo, long hi, char* idend, double x, double y) {
+    if (hi - lo <= 0) return INVALIDSTATION;
+
+    long mid = lo + (hi - lo) / 2;
+    KdNode* node = &kdvet[mid];
+    // Verifica se o id do nó atual corresponde ao id procurado
+    if (!strcmp(station_get(node->key)->idend, idend)) {
+        return node->key;
+    }
+
+    // Pontos com coordenada igual à da mediana podem estar em qualquer lado
+    double d = (node->axis == 0 ? x : y) - kd_coord(node, node->axis);
+    long ret = INVALIDSTATION;
+    if (d <= 0) {
+        ret = kdtree_search_rec(lo, mid, idend, x, y);
+    }
+    if (ret == INVALIDSTATION && d >= 0) {
+        ret = kdtree_search_rec(mid + 1, hi, idend, x, y);
+    }
+    return ret;
+}
+
+long kdtree_search(char* idend, double x, double y) {
+    // Verifica se a k-d tree está vazia
+    if (kdvetsz == 0) {
+        fprintf(stderr, "kdtree_search: tree empty\n");
+        return INVALIDSTATION;
+    }
+    return kdtree_search_rec(0, kdvetsz, idend, x, y);
+}
+
+// Função recursiva para encontrar os k pontos mais próximos no intervalo 
+// [lo, hi), visitando primeiro o lado da divisão que contém (x, y)
+static void kdtree_knn_rec(long lo, long hi, double x, double y, long k, const Filter* filter, Heap* heap) {
+    if (hi - lo <= 0) return;
+
+    long mid = lo + (hi - lo) / 2;
+    KdNode* node = &kdvet[mid];
+
+    // Considera o ponto do nó atual, se estiver ativo e satisfizer o filtro
+    if (station_is_active(node->key) && filter_match(filter, node->key)) {
+        double dist = sqrt(pow(node->x - x, 2) + pow(node->y - y, 2));
+        if (heap->size < k) {
+            heap_push(heap, (Neighbor) {node->key, dist});
+        }
+        else if (dist < heap->neighbors[0].dist) {
+            heap_pop(heap);
+            heap_push(heap, (Neighbor) {node->key, dist});
+        }
+    }
+
+    // Visita o lado mais próximo e, se necessário, o mais distante
+    double d = (node->axis == 0 ? x : y) - kd_coord(node, node->axis);
+    if (d < 0) {
+        kdtree_knn_rec(lo, mid, x, y, k, filter, heap);
+        if (heap->size < k || -d < heap->neighbors[0].dist) {
+            kdtree_knn_rec(mid + 1, hi, x, y, k, filter, heap);
+        }
+    }
+    else {
+        kdtree_knn_rec(mid + 1, hi, x, y, k, filter, heap);
+        if (heap->size < k || d < heap->neighbors[0].dist) {
+            kdtree_knn_rec(lo, mid, x, y, k, filter, heap);
+        }
+    }
+}
+
+// Função de comparação para o KNN
+static int cmpknn(const void* a, const void* b) {
+    Neighbor* k1 = (Neighbor*) a;
+    Neighbor* k2 = (Neighbor*) b;
+    // Compara as distâncias dos vizinhos
+    if (k1->dist > k2->dist) return 1;
+    else if (k1->dist < k2->dist) return -1;
+    else return 0;
+}
+
+long kdtree_knn(double x, double y, long k, const Filter* filter, Neighbor* result) {
+    // Verifica se a k-d tree está vazia
+    if (kdvetsz == 0) {
+        fprintf(stderr,"kdtree_knn: tree empty\n");
+        return 0;
+    }
+    // Inicializa um heap para armazenar os k vizinhos mais próximos
+    Heap* heap = heap_initialize(k);
+    kdtree_knn_rec(0, kdvetsz, x, y, k, filter, heap);
+
+    // Ordena os vizinhos encontrados pela distância e os copia para o 
+    // array de resultados
+    qsort(heap->neighbors, heap->size, sizeof(Neighbor), cmpknn);
+    memcpy(result, heap->neighbors, heap->size * sizeof(Neighbor));
+    long found = heap->size;
+    heap_destroy(heap);
+    return found;
+}
+
+const SpatialIndex kdtree_index = {
+    "kdtree",
+    kdtree_build,
+    kdtree_destroy,
+    NULL,
+    kdtree_search,
+    kdtree_knn,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    kdtree_memory
+};
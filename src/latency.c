@@ -0,0 +1,204 @@
+#include "latency.h"
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+
+// Variáveis encapsuladas que mantêm os histogramas e a medição em curso
+Histogram histograms[LAT_NSERIES][LAT_NPHASES]; // Histogramas por série e fase
+uint64_t latstart = 0; // Início do comando em curso
+uint64_t latmark = 0; // Última marcação do comando em curso
+uint64_t latphase[LAT_NPHASES]; // Tempo acumulado por fase no comando em curso
+const char* latpath = NULL; // Arquivo do relatório gerado por sinal
+volatile sig_atomic_t latrequested = 0; // Relatório solicitado por sinal
+latency_page_counter pagecounter = NULL; // Contadores do pool de páginas
+Histogram pagehistograms[LAT_NSERIES]; // Faltas de página por comando, por série
+uint64_t pagehitsum[LAT_NSERIES]; // Acertos no pool, por série
+uint64_t latfaults = 0; // Faltas acumuladas no início do comando em curso
+uint64_t lathits = 0; // Acertos acumulados no início do comando em curso
+
+// Nomes das fases no relatório
+static const char* phasenames[LAT_NPHASES] = {"parse", "search", "output", "total"};
+
+// Funções privadas
+static int latency_bucket(uint64_t v);
+static uint64_t latency_bucket_upper(int b);
+static uint64_t latency_percentile(Histogram* h, double p);
+static void latency_on_signal(int sig);
+
+uint64_t latency_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// Retorna o balde do valor v: valores menores que LAT_SUBBUCKETS têm balde 
+// próprio; os demais são agrupados pela posição do bit mais significativo e
+// pelos dois bits seguintes
+static int latency_bucket(uint64_t v) {
+    if (v < LAT_SUBBUCKETS) return (int) v;
+    int e = 63 - __builtin_clzll(v);
+    int sub = (int) ((v >> (e - 2)) & (LAT_SUBBUCKETS - 1));
+    return LAT_SUBBUCKETS + (e - 2) * LAT_SUBBUCKETS + sub;
+}
+
+// Retorna o maior valor que cai no balde b
+static uint64_t latency_bucket_upper(int b) {
+    if (b < LAT_SUBBUCKETS) return (uint64_t) b;
+    int e = (b - LAT_SUBBUCKETS) / LAT_SUBBUCKETS + 2;
+    int sub = (b - LAT_SUBBUCKETS) % LAT_SUBBUCKETS;
+    return ((uint64_t) (LAT_SUBBUCKETS + sub + 1) << (e - 2)) - 1;
+}
+
+int latency_series(char op, long n) {
+    if (op == 'A') return 0;
+    if (op == 'D') return 1;
+    int c = 0;
+    while (n > 1 && c < LAT_NCLASSES - 1) {
+        n >>= 1;
+        c++;
+    }
+    return 2 + c;
+}
+
+void latency_record(int series, int phase, uint64_t ns) {
+    Histogram* h = &histograms[series][phase];
+    h->count++;
+    h->sum += ns;
+    if (ns > h->max) h->max = ns;
+    h->buckets[latency_bucket(ns)]++;
+}
+
+void latency_track_pages(latency_page_counter counter) {
+    pagecounter = counter;
+}
+
+void latency_page_counts(uint64_t* faults, uint64_t* hits) {
+    *faults = *hits = 0;
+    if (pagecounter != NULL) pagecounter(faults, hits);
+}
+
+void latency_record_pages(int series, uint64_t faults, uint64_t hits) {
+    Histogram* h = &pagehistograms[series];
+    h->count++;
+    h->sum += faults;
+    if (faults > h->max) h->max = faults;
+    h->buckets[latency_bucket(faults)]++;
+    pagehitsum[series] += hits;
+}
+
+void latency_begin() {
+    latstart = latmark = latency_now();
+    memset(latphase, 0, sizeof(latphase));
+    latency_page_counts(&latfaults, &lathits);
+}
+
+void latency_mark(int phase) {
+    uint64_t now = latency_now();
+    latphase[phase] += now - latmark;
+    latmark = now;
+}
+
+void latency_end(int series) {
+    for (int p = 0; p < LAT_TOTAL; p++) {
+        latency_record(series, p, latphase[p]);
+    }
+    latency_record(series, LAT_TOTAL, latency_now() - latstart);
+    if (pagecounter != NULL) {
+        uint64_t faults, hits;
+        latency_page_counts(&faults, &hits);
+        latency_record_pages(series, faults - latfaults, hits - lathits);
+    }
+}
+
+// Retorna o percentil p (entre 0 e 1) do histograma, limitado ao máximo
+static uint64_t latency_percentile(Histogram* h, double p) {
+    uint64_t rank = (uint64_t) (p * h->count);
+    if (rank >= h->count) rank = h->count - 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen > rank) {
+            uint64_t upper = latency_bucket_upper(b);
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+void latency_dump(FILE* out) {
+    fprintf(out, "{\n  \"unit\": \"us\",\n  \"series\": {");
+    bool first = true;
+    for (int s = 0; s < LAT_NSERIES; s++) {
+        if (histograms[s][LAT_TOTAL].count == 0) continue;
+
+        // Nome da série: o comando e, para consultas, a faixa de n
+        char name[64];
+        if (s < 2) {
+            snprintf(name, sizeof(name), "%c", s == 0 ? 'A' : 'D');
+        }
+        else if (s == 2) {
+            snprintf(name, sizeof(name), "C n=1");
+        }
+        else if (s == LAT_NSERIES - 1) {
+            snprintf(name, sizeof(name), "C n>=%ld", 1L << (s - 2));
+        }
+        else {
+            snprintf(name, sizeof(name), "C n=%ld-%ld", 1L << (s - 2), (1L << (s - 1)) - 1);
+        }
+
+        fprintf(out, "%s\n    \"%s\": {\n      \"count\": %lu", first ? "" : ",", name,
+                (unsigned long) histograms[s][LAT_TOTAL].count);
+        first = false;
+        for (int p = 0; p < LAT_NPHASES; p++) {
+            Histogram* h = &histograms[s][p];
+            fprintf(out, ",\n      \"%s\": {\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+                    phasenames[p], h->sum / 1000.0 / h->count,
+                    latency_percentile(h, 0.50) / 1000.0, latency_percentile(h, 0.90) / 1000.0,
+                    latency_percentile(h, 0.99) / 1000.0, h->max / 1000.0);
+        }
+        // Faltas de página por comando e taxa de acertos no pool
+        Histogram* h = &pagehistograms[s];
+        if (h->count > 0) {
+            uint64_t accesses = h->sum + pagehitsum[s];
+            fprintf(out, ",\n      \"pages\": {\"faults_mean\": %.3f, \"faults_p50\": %lu, \"faults_p99\": %lu, \"faults_max\": %lu, \"hit_rate\": %.4f}",
+                    (double) h->sum / h->count, (unsigned long) latency_percentile(h, 0.50),
+                    (unsigned long) latency_percentile(h, 0.99), (unsigned long) h->max,
+                    accesses ? (double) pagehitsum[s] / accesses : 1.0);
+        }
+        fprintf(out, "\n    }");
+    }
+    fprintf(out, "\n  }\n}\n");
+}
+
+void latency_dump_file(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        fprintf(stderr, "latency_dump_file: could not open %s\n", path);
+        return;
+    }
+    latency_dump(out);
+    fclose(out);
+}
+
+static void latency_on_signal(int sig) {
+    (void) sig;
+    latrequested = 1;
+}
+
+void latency_install_signal(const char* path) {
+    latpath = path;
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = latency_on_signal;
+    // Chamadas bloqueantes interrompidas pelo sinal (por exemplo, a leitura
+    // da entrada padrão no modo servidor) são retomadas
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+}
+
+void latency_poll() {
+    if (!latrequested) return;
+    latrequested = 0;
+    if (latpath != NULL) latency_dump_file(latpath);
+    else latency_dump(stderr);
+}
@@ -0,0 +1,279 @@
+#include "loader.h"
+
+// Bloco do arquivo base, formado por linhas completas
+typedef struct {
+    const char* begin;  // Início do bloco, sempre no início de uma linha
+    const char* end;    // Fim do bloco
+    long lines;         // Número de linhas do bloco
+    long records;       // Número de pontos de recarga (linhas não vazias)
+    long firstline;     // Número, no arquivo, da primeira linha do bloco
+    long firstid;       // Identificador do primeiro ponto de recarga do bloco
+    long errline;       // Número, no arquivo, da linha inválida (0 se não houver)
+    const char* error;  // Descrição do erro encontrado na linha errline
+    Arena strings;      // Strings dos pontos de recarga do bloco
+} LoaderChunk;
+
+// Estado compartilhado pelas threads de uma fase da leitura
+typedef struct {
+    LoaderChunk* chunks;    // Blocos do arquivo
+    long nchunks;           // Número de blocos
+    atomic_long next;       // Próximo bloco a ser processado
+    bool parse;             // Indica se a fase interpreta ou apenas conta as linhas
+} LoaderTask;
+
+// Função auxiliar que retorna o início da linha seguinte à que começa em p e
+// armazena em lineend o fim do conteúdo da linha, sem a quebra de linha
+static const char* next_line(const char* p, const char* end, const char** lineend) {
+    const char* nl = (const char*) memchr(p, '\n', end - p);
+    const char* next = nl != NULL ? nl + 1 : end;
+    if (nl == NULL) nl = end;
+    // Aceita também arquivos com quebras de linha "\r\n"
+    if (nl > p && nl[-1] == '\r') nl--;
+    *lineend = nl;
+    return next;
+}
+
+// Funções auxiliares que convertem um campo inteiro ou real, verificando se
+// todo o campo foi consumido
+static bool parse_long(const char* s, long* v) {
+    char* end;
+    errno = 0;
+    *v = strtol(s, &end, 10);
+    return end != s && *end == '\0' && errno == 0;
+}
+
+static bool parse_double(const char* s, double* v) {
+    char* end;
+    errno = 0;
+    *v = strtod(s, &end);
+    return end != s && *end == '\0' && errno == 0;
+}
+
+// Número de campos de cada linha do arquivo base
+#define LOADER_NFIELDS 10
+
+// Função auxiliar que interpreta a linha [p, lineend) no ponto de recarga it,
+// copiando as strings para a arena a. Retorna NULL em caso de sucesso ou a
+// descrição do erro
+static const char* parse_line(const char* p, const char* lineend, Item* it, Arena* a) {
+    char buffer[LOADER_MAXLINE];
+    size_t len = lineend - p;
+    if (len >= sizeof(buffer)) return "linha muito longa";
+    memcpy(buffer, p, len);
+    buffer[len] = 0;
+
+    // Separa os campos da linha
+    char* fields[LOADER_NFIELDS];
+    char* save;
+    char* token = strtok_r(buffer, ";", &save);
+    int nfields = 0;
+    while (token != NULL && nfields < LOADER_NFIELDS) {
+        fields[nfields++] = token;
+        token = strtok_r(NULL, ";", &save);
+    }
+    if (nfields < LOADER_NFIELDS) return "campos insuficientes";
+    if (token != NULL) return "campos em excesso";
+
+    // Converte os campos numéricos
+    long id_logrado, numero_imo, cep;
+    double x, y;
+    if (!parse_long(fields[1], &id_logrado)) return "id_logrado invalido";
+    if (!parse_long(fields[4], &numero_imo)) return "numero_imo invalido";
+    if (!parse_long(fields[7], &cep)) return "cep invalido";
+    if (!parse_double(fields[8], &x)) return "coordenada x invalida";
+    if (!parse_double(fields[9], &y)) return "coordenada y invalida";
+
+    it->idend = arena_strdup(a, fields[0]);
+    it->id_logrado = id_logrado;
+    it->sigla_tipo = arena_strdup(a, fields[2]);
+    it->nome_logra = arena_strdup(a, fields[3]);
+    it->numero_imo = (int) numero_imo;
+    it->nome_bairr = arena_strdup(a, fields[5]);
+    it->nome_regio = arena_strdup(a, fields[6]);
+    it->cep = (int) cep;
+    it->x = x;
+    it->y = y;
+    return NULL;
+}
+
+// Função auxiliar que conta as linhas e os pontos de recarga de um bloco
+static void count_chunk(LoaderChunk* c) {
+    const char* p = c->begin;
+    while (p < c->end) {
+        const char* lineend;
+        const char* next = next_line(p, c->end, &lineend);
+        c->lines++;
+        if (lineend > p) c->records++;
+        p = next;
+    }
+}
+
+// Função auxiliar que interpreta os pontos de recarga de um bloco, a partir
+// da posição firstid do vetor, parando na primeira linha inválida
+static void parse_chunk(LoaderChunk* c) {
+    const char* p = c->begin;
+    long line = c->firstline;
+    long id = c->firstid;
+    while (p < c->end) {
+        const char* lineend;
+        const char* next = next_line(p, c->end, &lineend);
+        // Linhas vazias são ignoradas
+        if (lineend > p) {
+            const char* error = parse_line(p, lineend, station_get(id), &c->strings);
+            if (error != NULL) {
+                c->errline = line;
+                c->error = error;
+                return;
+            }
+            id++;
+        }
+        p = next;
+        line++;
+    }
+}
+
+// Função executada por cada thread: processa blocos até que não restem mais
+static void* loader_worker(void* arg) {
+    LoaderTask* t = (LoaderTask*) arg;
+    long c;
+    while ((c = atomic_fetch_add(&t->next, 1)) < t->nchunks) {
+        if (t->parse) parse_chunk(&t->chunks[c]);
+        else count_chunk(&t->chunks[c]);
+    }
+    return NULL;
+}
+
+// Função auxiliar que executa uma fase da leitura com nthreads threads
+static void loader_run(LoaderTask* t, int nthreads) {
+    pthread_t threads[nthreads];
+    atomic_init(&t->next, 0);
+    int started = 0;
+    for (int i = 1; i < nthreads; i++) {
+        if (pthread_create(&threads[started], NULL, loader_worker, t) != 0) {
+            fprintf(stderr,"loader_run: could not create thread\n");
+            break;
+        }
+        started++;
+    }
+    // A thread atual também processa blocos
+    loader_worker(t);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+long loader_read_base(const char* filename, int nthreads) {
+    // Mapeia o arquivo em memória, para que as threads leiam seus blocos
+    // diretamente
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o arquivo %s\n", filename);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o arquivo %s\n", filename);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t) st.st_size;
+    const char* data = NULL;
+    if (size > 0) {
+        data = (const char*) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            fprintf(stderr, "Erro: nao foi possivel mapear o arquivo %s\n", filename);
+            close(fd);
+            return -1;
+        }
+        madvise((void*) data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    const char* end = data + size;
+
+    // Lê o número de pontos de recarga da primeira linha
+    long expected = -1;
+    const char* body = end;
+    if (size > 0) {
+        const char* lineend;
+        body = next_line(data, end, &lineend);
+        char header[32];
+        size_t len = lineend - data;
+        if (len < sizeof(header)) {
+            memcpy(header, data, len);
+            header[len] = 0;
+            if (!parse_long(header, &expected)) expected = -1;
+        }
+    }
+    if (expected < 0) {
+        fprintf(stderr, "Erro: nao foi possivel ler o numero de pontos de recarga\n");
+        if (data != NULL) munmap((void*) data, size);
+        return -1;
+    }
+
+    // Divide o restante do arquivo em blocos de tamanho semelhante, cujo
+    // início é avançado até o início da linha seguinte
+    if (nthreads < 1) nthreads = 1;
+    size_t bodysz = end - body;
+    long nchunks = (long) nthreads * LOADER_CHUNKS_PER_THREAD;
+    if ((size_t) nchunks > bodysz / LOADER_MINCHUNK + 1) nchunks = bodysz / LOADER_MINCHUNK + 1;
+    if (nthreads > nchunks) nthreads = nchunks;
+    LoaderChunk* chunks = (LoaderChunk*) calloc(nchunks, sizeof(LoaderChunk));
+    if (chunks == NULL) {
+        fprintf(stderr,"loader_read_base: could not allocate chunks\n");
+        if (data != NULL) munmap((void*) data, size);
+        return -1;
+    }
+    for (long c = 0; c < nchunks; c++) {
+        const char* p = body + bodysz * c / nchunks;
+        while (c > 0 && p < end && p[-1] != '\n') p++;
+        chunks[c].begin = p;
+        chunks[c].strings = EMPTYARENA;
+        if (c > 0) chunks[c - 1].end = p;
+    }
+    chunks[nchunks - 1].end = end;
+
+    // Primeira fase: conta as linhas de cada bloco, o que define a posição
+    // de cada ponto de recarga no vetor e o número de cada linha
+    LoaderTask task = {chunks, nchunks, 0, false};
+    loader_run(&task, nthreads);
+    long total = 0;
+    long line = 2;
+    for (long c = 0; c < nchunks; c++) {
+        chunks[c].firstid = total;
+        chunks[c].firstline = line;
+        total += chunks[c].records;
+        line += chunks[c].lines;
+    }
+
+    // O vetor só é preenchido se o cabeçalho corresponder ao arquivo
+    long ret = total;
+    if (total != expected) {
+        fprintf(stderr, "Erro: o arquivo %s indica %ld pontos de recarga, mas contem %ld\n", filename, expected, total);
+        ret = -1;
+    }
+    else if (station_initialize(total) != total || station_add_block(total) != 0) {
+        ret = -1;
+    }
+    else {
+        // Segunda fase: interpreta os blocos diretamente no vetor
+        task.parse = true;
+        loader_run(&task, nthreads);
+        for (long c = 0; c < nchunks; c++) {
+            if (chunks[c].error != NULL) {
+                fprintf(stderr, "Erro: %s, linha %ld: %s\n", filename, chunks[c].errline, chunks[c].error);
+                ret = -1;
+                break;
+            }
+        }
+    }
+
+    // As strings de cada bloco passam a pertencer ao vetor de pontos de
+    // recarga, ou são descartadas com ele em caso de erro
+    for (long c = 0; c < nchunks; c++) {
+        station_adopt_strings(&chunks[c].strings);
+    }
+    if (ret < 0) station_destroy();
+    free(chunks);
+    if (data != NULL) munmap((void*) data, size);
+    return ret;
+}
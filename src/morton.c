@@ -0,0 +1,28 @@
+#include "morton.h"
+
+// Função auxiliar que quantiza a coordenada v no intervalo [min, max] em 16
+// bits, saturando valores fora do intervalo
+static uint32_t morton_quantize(double v, double min, double max) {
+    if (!(max > min)) return 0;
+    double t = (v - min) / (max - min);
+    if (t <= 0) return 0;
+    if (t >= 1) return 0xFFFF;
+    return (uint32_t) (t * 0xFFFF);
+}
+
+// Função auxiliar que intercala os 16 bits menos significativos de v com
+// zeros (bit i vai para a posição 2i)
+static uint32_t morton_spread(uint32_t v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+uint32_t morton_encode(Boundary* bd, double x, double y) {
+    uint32_t qx = morton_quantize(x, bd->x_min, bd->x_max);
+    uint32_t qy = morton_quantize(y, bd->y_min, bd->y_max);
+    return morton_spread(qx) | (morton_spread(qy) << 1);
+}
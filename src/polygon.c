@@ -0,0 +1,80 @@
+#include "polygon.h"
+
+Polygon* polygon_read(const char* filename, long* n, Arena* a) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel abrir o arquivo %s\n", filename);
+        return NULL;
+    }
+    long count;
+    if (fscanf(file, "%ld", &count) != 1 || count < 0) {
+        fprintf(stderr, "Erro: nao foi possivel ler o numero de poligonos de %s\n", filename);
+        fclose(file);
+        return NULL;
+    }
+    Polygon* polys = (Polygon*) arena_alloc(a, (count > 0 ? count : 1) * sizeof(Polygon));
+    for (long i = 0; i < count; i++) {
+        Polygon* p = &polys[i];
+        char name[256];
+        // Um polígono precisa de pelo menos três vértices
+        if (fscanf(file, "%255s %ld", name, &p->n) != 2 || p->n < 3) {
+            fprintf(stderr, "Erro: poligono %ld invalido em %s\n", i + 1, filename);
+            fclose(file);
+            return NULL;
+        }
+        p->name = arena_strdup(a, name);
+        p->xs = (double*) arena_alloc(a, p->n * sizeof(double));
+        p->ys = (double*) arena_alloc(a, p->n * sizeof(double));
+        for (long v = 0; v < p->n; v++) {
+            if (fscanf(file, "%lf %lf", &p->xs[v], &p->ys[v]) != 2) {
+                fprintf(stderr, "Erro: poligono %s incompleto em %s\n", p->name, filename);
+                fclose(file);
+                return NULL;
+            }
+        }
+        // Calcula o retângulo envolvente
+        p->bb = (Boundary) {p->xs[0], p->xs[0], p->ys[0], p->ys[0]};
+        for (long v = 1; v < p->n; v++) {
+            p->bb.x_min = fmin(p->bb.x_min, p->xs[v]);
+            p->bb.x_max = fmax(p->bb.x_max, p->xs[v]);
+            p->bb.y_min = fmin(p->bb.y_min, p->ys[v]);
+            p->bb.y_max = fmax(p->bb.y_max, p->ys[v]);
+        }
+    }
+    fclose(file);
+    *n = count;
+    return polys;
+}
+
+bool polygon_contains(const Polygon* p, double x, double y) {
+    if (x < p->bb.x_min || x > p->bb.x_max || y < p->bb.y_min || y > p->bb.y_max) {
+        return false;
+    }
+    // Conta as arestas atravessadas por uma semirreta horizontal a partir do
+    // ponto
+    bool inside = false;
+    for (long i = 0, j = p->n - 1; i < p->n; j = i++) {
+        if ((p->ys[i] > y) != (p->ys[j] > y) &&
+            x < (p->xs[j] - p->xs[i]) * (y - p->ys[i]) / (p->ys[j] - p->ys[i]) + p->xs[i]) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+int polygon_classify(const Polygon* p, const Boundary* bd) {
+    // Retângulos disjuntos do retângulo envolvente estão fora do polígono
+    if (bd->x_max < p->bb.x_min || bd->x_min > p->bb.x_max ||
+        bd->y_max < p->bb.y_min || bd->y_min > p->bb.y_max) {
+        return POLY_OUTSIDE;
+    }
+    for (long i = 0, j = p->n - 1; i < p->n; j = i++) {
+        if (boundary_hits_segment(bd, p->xs[j], p->ys[j], p->xs[i], p->ys[i])) {
+            return POLY_PARTIAL;
+        }
+    }
+    // Nenhuma aresta toca o retângulo: basta testar um de seus pontos
+    double cx = (bd->x_min + bd->x_max) / 2;
+    double cy = (bd->y_min + bd->y_max) / 2;
+    return polygon_contains(p, cx, cy) ? POLY_INSIDE : POLY_OUTSIDE;
+}
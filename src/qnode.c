@@ -5,35 +5,40 @@ QuadTreeNode* nodevet = NULL; // Vetor de nós da QuadTree
 Boundary boundary = INVALIDBOUNDARY; // Limites padrão inválidos
 long nodevetsz = 0; // Tamanho do vetor de nós
 long nodesallocated = 0; // Número de nós alocados
-long firstavail = INVALIDADDR; // Primeiro endereço disponível
 
-// Definição de um nó inválido
-#define INVALIDNODE {boundary, INVALIDKEY, INVALIDADDR, INVALIDADDR, INVALIDADDR, INVALIDADDR}
+// Os nós nunca são removidos individualmente, então a alocação é sequencial:
+// os nós em [0, nodesallocated) estão em uso e os demais estão disponíveis
 
-// Função auxiliar para verificar se um nó é inválido
-static bool is_invalid_node(QuadTreeNode* node) {
-    QuadTreeNode invalid_node = INVALIDNODE;
-    return memcmp(node, &invalid_node, sizeof(QuadTreeNode)) == 0;
-}
+// Variáveis encapsuladas que mantêm o modo paginado: os nós ficam em páginas
+// de um arquivo e apenas poolframes páginas ficam em memória, no pool
+int pagefd = -1; // Descritor do arquivo de páginas (-1 fora do modo paginado)
+long numpages = 0; // Número de páginas no arquivo
+long pagecap = 0; // Capacidade dos vetores indexados por página
+uint16_t* pagefill = NULL; // Número de nós alocados em cada página
+int32_t* pageframe = NULL; // Quadro do pool que contém cada página, ou -1
+long poolframes = 0; // Número de quadros do pool
+QuadTreeNode* poolmem = NULL; // Conteúdo dos quadros
+long* framepage = NULL; // Página contida em cada quadro, ou -1
+bool* framedirty = NULL; // Indica se o quadro foi alterado desde a leitura
+long* frameprev = NULL; // Quadro usado mais recentemente que este
+long* framenext = NULL; // Quadro usado menos recentemente que este
+long lruhead = -1; // Quadro usado mais recentemente
+long lrutail = -1; // Quadro usado menos recentemente
+uint64_t pagefaults = 0; // Páginas lidas do arquivo (ou criadas)
+uint64_t pagehits = 0; // Acessos a páginas que já estavam no pool
+pthread_mutex_t poollock = PTHREAD_MUTEX_INITIALIZER; // Serializa o pool
 
 // Função para resetar um nó, removendo qualquer informação de uso anterior
 void node_reset(QuadTreeNode* pn) {
-    pn->boundary = boundary;
+    pn->x = 0;
+    pn->y = 0;
     pn->key = INVALIDKEY;
-    pn->ne = INVALIDADDR;
-    pn->nw = INVALIDADDR;
-    pn->se = INVALIDADDR;
-    pn->sw = INVALIDADDR;
+    pn->child = INVALIDADDR;
 }
 
 // Função para copiar o conteúdo de um nó src para um nó dst
 void node_copy(QuadTreeNode* dst, QuadTreeNode* src) {
-    dst->key = src->key;
-    dst->boundary = src->boundary;
-    dst->nw = src->nw;
-    dst->ne = src->ne;
-    dst->sw = src->sw;
-    dst->se = src->se;
+    *dst = *src;
 }
 
 // Função para inicializar um vetor de nós que conterá no máximo numnodes
@@ -48,65 +53,236 @@ long node_initialize(long numnodes, Boundary qt_boundary) {
     boundary = qt_boundary;
     // Inicializa o tamanho do vetor de nós
     nodevetsz = numnodes;
-    // Cria a cadeia de nós disponíveis como uma lista encadeada
+    nodesallocated = 0;
     for (long i = 0; i < nodevetsz; i++) {
         node_reset(&(nodevet[i]));
-        nodevet[i].nw = (nodeaddr_t) i + 1;
     }
-    // Último nó na cadeia
-    nodevet[nodevetsz - 1].nw = INVALIDADDR;
-    // Nó 0 é o primeiro disponível
-    firstavail = (nodeaddr_t) 0;
     return numnodes;
 }
 
+// Função auxiliar que remove o quadro f da lista LRU
+static void lru_unlink(long f) {
+    if (frameprev[f] >= 0) framenext[frameprev[f]] = framenext[f];
+    else lruhead = framenext[f];
+    if (framenext[f] >= 0) frameprev[framenext[f]] = frameprev[f];
+    else lrutail = frameprev[f];
+    frameprev[f] = framenext[f] = -1;
+}
+
+// Função auxiliar que coloca o quadro f no início da lista LRU
+static void lru_push(long f) {
+    frameprev[f] = -1;
+    framenext[f] = lruhead;
+    if (lruhead >= 0) frameprev[lruhead] = f;
+    lruhead = f;
+    if (lrutail < 0) lrutail = f;
+}
+
+// Função auxiliar que grava o quadro f no arquivo, se tiver sido alterado
+static void frame_flush(long f) {
+    if (framepage[f] < 0 || !framedirty[f]) return;
+    off_t offset = (off_t) framepage[f] * NODE_PAGESZ;
+    if (pwrite(pagefd, &poolmem[f * NODES_PER_PAGE], NODE_PAGESZ, offset) != NODE_PAGESZ) {
+        perror("node: could not write page");
+    }
+    framedirty[f] = false;
+}
+
+// Função auxiliar que retorna o quadro que contém a página p, lendo-a do 
+// arquivo (ou criando-a, se fresh) no quadro usado menos recentemente
+static long pool_fetch(long p, bool fresh) {
+    long f = pageframe[p];
+    if (f >= 0) {
+        pagehits++;
+        lru_unlink(f);
+        lru_push(f);
+        return f;
+    }
+    pagefaults++;
+    // Usa o quadro menos recente, gravando a página que ele contém
+    f = lrutail;
+    lru_unlink(f);
+    if (framepage[f] >= 0) {
+        frame_flush(f);
+        pageframe[framepage[f]] = -1;
+    }
+    QuadTreeNode* frame = &poolmem[f * NODES_PER_PAGE];
+    if (fresh) {
+        for (long i = 0; i < (long) NODES_PER_PAGE; i++) {
+            node_reset(&frame[i]);
+        }
+        framedirty[f] = true;
+    }
+    else {
+        off_t offset = (off_t) p * NODE_PAGESZ;
+        if (pread(pagefd, frame, NODE_PAGESZ, offset) != NODE_PAGESZ) {
+            perror("node: could not read page");
+        }
+        framedirty[f] = false;
+    }
+    framepage[f] = p;
+    pageframe[p] = f;
+    lru_push(f);
+    return f;
+}
+
+// Função auxiliar que acrescenta uma página vazia ao arquivo
+static long page_new() {
+    if (numpages == pagecap) {
+        pagecap = pagecap ? 2 * pagecap : 1024;
+        pagefill = (uint16_t*) realloc(pagefill, pagecap * sizeof(uint16_t));
+        pageframe = (int32_t*) realloc(pageframe, pagecap * sizeof(int32_t));
+    }
+    long p = numpages++;
+    pagefill[p] = 0;
+    pageframe[p] = -1;
+    pool_fetch(p, true);
+    return p;
+}
+
+long node_initialize_paged(const char* path, long numnodes, Boundary qt_boundary, size_t budget) {
+    pagefd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (pagefd < 0) {
+        perror("node_initialize_paged: could not open page file");
+        return 0;
+    }
+    // O pool precisa de ao menos alguns quadros para uma descida da árvore
+    poolframes = budget / NODE_PAGESZ;
+    if (poolframes < NODE_MINFRAMES) poolframes = NODE_MINFRAMES;
+    poolmem = (QuadTreeNode*) malloc(poolframes * NODE_PAGESZ);
+    framepage = (long*) malloc(poolframes * sizeof(long));
+    framedirty = (bool*) malloc(poolframes * sizeof(bool));
+    frameprev = (long*) malloc(poolframes * sizeof(long));
+    framenext = (long*) malloc(poolframes * sizeof(long));
+    if (poolmem == NULL || framepage == NULL || framedirty == NULL || frameprev == NULL || framenext == NULL) {
+        fprintf(stderr,"node_initialize_paged: could not allocate pool\n");
+        node_destroy();
+        return 0;
+    }
+    lruhead = lrutail = -1;
+    for (long f = 0; f < poolframes; f++) {
+        framepage[f] = -1;
+        framedirty[f] = false;
+        lru_push(f);
+    }
+    boundary = qt_boundary;
+    // No modo paginado, o arquivo cresce conforme necessário
+    nodevetsz = numnodes;
+    nodesallocated = 0;
+    numpages = 0;
+    pagefaults = pagehits = 0;
+    return numnodes;
+}
+
+// Função auxiliar que reserva count nós consecutivos em uma página, de 
+// preferência na mesma página do nó near, para que subárvores compartilhem
+// páginas. Se ela estiver cheia, usa a última página criada, que reúne os 
+// nós que transbordaram recentemente, e só então cria uma nova página
+static nodeaddr_t page_alloc(nodeaddr_t near, int count) {
+    long p = near >= 0 ? near / (long) NODES_PER_PAGE : -1;
+    if (p < 0 || pagefill[p] + count > (long) NODES_PER_PAGE) {
+        p = numpages - 1;
+    }
+    if (p < 0 || pagefill[p] + count > (long) NODES_PER_PAGE) {
+        p = page_new();
+    }
+    nodeaddr_t ret = (nodeaddr_t) (p * NODES_PER_PAGE + pagefill[p]);
+    pagefill[p] += count;
+    nodesallocated += count;
+    return ret;
+}
+
 // Função para criar um nó a partir de pn
 nodeaddr_t node_create(QuadTreeNode* pn) {
-    nodeaddr_t ret;
-    // Remove um nó da cadeia de disponíveis, atualiza os controles e copia pn 
-	// para ele
-    ret = firstavail;
-    firstavail = nodevet[ret].nw;
-    nodesallocated++;
+    if (pagefd >= 0) {
+        pthread_mutex_lock(&poollock);
+        nodeaddr_t ret = page_alloc(INVALIDADDR, 1);
+        long f = pool_fetch(ret / NODES_PER_PAGE, false);
+        node_copy(&poolmem[f * NODES_PER_PAGE + ret % NODES_PER_PAGE], pn);
+        framedirty[f] = true;
+        pthread_mutex_unlock(&poollock);
+        return ret;
+    }
+    // Verifica se ainda há nós disponíveis
+    if (nodesallocated >= nodevetsz) {
+        fprintf(stderr,"node_create: nodevet full\n");
+        return INVALIDADDR;
+    }
+    nodeaddr_t ret = (nodeaddr_t) nodesallocated++;
     node_copy(&(nodevet[ret]), pn);
     return ret;
 }
 
-// Função para deletar virtualmente um nó, tornando-o disponível para futura 
-// criação
-void node_delete(nodeaddr_t ad) {
-    // Verifica se o endereço é válido
-    if (ad < 0 || ad >= nodevetsz) {
-        fprintf(stderr,"node_delete: address out of range\n");
-        return;
+// Função para criar os quatro filhos de um nó em posições consecutivas
+nodeaddr_t node_create_children(nodeaddr_t parent) {
+    if (pagefd >= 0) {
+        // As páginas novas já são criadas com nós resetados
+        pthread_mutex_lock(&poollock);
+        nodeaddr_t ret = page_alloc(parent, 4);
+        pthread_mutex_unlock(&poollock);
+        return ret;
     }
-    if (is_invalid_node(&(nodevet[ad]))) {
-        fprintf(stderr,"node_delete: node already deleted\n");
+    // Verifica se ainda há nós disponíveis para o bloco inteiro
+    if (nodesallocated + 4 > nodevetsz) {
+        fprintf(stderr,"node_create_children: nodevet full\n");
+        return INVALIDADDR;
     }
-    // Apenas reseta e adiciona à frente da lista de disponíveis
-    node_reset(&(nodevet[ad]));
-    nodevet[ad].nw = firstavail;
-    firstavail = ad;
-    nodesallocated--;
+    nodeaddr_t ret = (nodeaddr_t) nodesallocated;
+    nodesallocated += 4;
+    // Os nós disponíveis já estão resetados desde a inicialização
+    return ret;
 }
 
 // Função para recuperar um nó do vetor a partir do endereço ad e copiá-lo para 
 // pn
 void node_get(nodeaddr_t ad, QuadTreeNode* pn) {
+    if (pagefd >= 0) {
+        long p = ad / (long) NODES_PER_PAGE;
+        if (ad < 0 || p >= numpages || ad % (long) NODES_PER_PAGE >= pagefill[p]) {
+            fprintf(stderr,"node_get: address out of range\n");
+            node_reset(pn);
+            return;
+        }
+        pthread_mutex_lock(&poollock);
+        long f = pool_fetch(p, false);
+        node_copy(pn, &poolmem[f * NODES_PER_PAGE + ad % NODES_PER_PAGE]);
+        pthread_mutex_unlock(&poollock);
+        return;
+    }
     // Verifica se o endereço é válido
     if (ad < 0 || ad >= nodevetsz) {
         fprintf(stderr,"node_get: address out of range\n");
-        pn->key = INVALIDKEY;
+        node_reset(pn);
         return;
     }
-    if (is_invalid_node(&(nodevet[ad]))) {
+    if (ad >= nodesallocated) {
         fprintf(stderr,"node_get: node is invalid\n");
     }
     node_copy(pn, &(nodevet[ad]));
 }
 
+// Função para antecipar a leitura do nó no endereço ad para a cache; no modo
+// paginado, e para endereços inválidos, não faz nada
+void node_prefetch(nodeaddr_t ad) {
+    if (pagefd >= 0 || ad < 0 || ad >= nodesallocated) return;
+    __builtin_prefetch(&nodevet[ad]);
+}
+
 // Função para armazenar um nó no vetor a partir do endereço ad e copiá-lo de pn
 void node_put(nodeaddr_t ad, QuadTreeNode* pn) {
+    if (pagefd >= 0) {
+        long p = ad / (long) NODES_PER_PAGE;
+        if (ad < 0 || p >= numpages || ad % (long) NODES_PER_PAGE >= pagefill[p]) {
+            fprintf(stderr,"node_put: address out of range\n");
+            return;
+        }
+        pthread_mutex_lock(&poollock);
+        long f = pool_fetch(p, false);
+        node_copy(&poolmem[f * NODES_PER_PAGE + ad % NODES_PER_PAGE], pn);
+        framedirty[f] = true;
+        pthread_mutex_unlock(&poollock);
+        return;
+    }
     // Verifica se o endereço é válido
     if (ad < 0 || ad >= nodevetsz) {
         fprintf(stderr,"node_put: address out of range\n");
@@ -115,11 +291,44 @@ void node_put(nodeaddr_t ad, QuadTreeNode* pn) {
     node_copy(&(nodevet[ad]), pn);
 }
 
+Boundary node_boundary() {
+    return boundary;
+}
+
+bool node_paged() {
+    return pagefd >= 0;
+}
+
+void node_page_stats(uint64_t* faults, uint64_t* hits) {
+    *faults = pagefaults;
+    *hits = pagehits;
+}
+
 // Função para destruir o vetor de nós, liberando a memória alocada
 void node_destroy() {
     free(nodevet);
     nodevet = NULL;
     nodevetsz = 0;
     nodesallocated = 0;
-    firstavail = INVALIDADDR;
-}
\ No newline at end of file
+    boundary = INVALIDBOUNDARY;
+
+    // No modo paginado, libera o pool e fecha o arquivo de páginas, cujo 
+    // conteúdo não é reaproveitado
+    if (pagefd >= 0) close(pagefd);
+    pagefd = -1;
+    free(poolmem); free(framepage); free(framedirty); free(frameprev); free(framenext);
+    free(pagefill); free(pageframe);
+    poolmem = NULL; framepage = NULL; framedirty = NULL; frameprev = NULL; framenext = NULL;
+    pagefill = NULL; pageframe = NULL;
+    poolframes = numpages = pagecap = 0;
+    lruhead = lrutail = -1;
+}
+
+size_t node_memory() {
+    if (pagefd >= 0) {
+        // Apenas o pool e os vetores por página ficam em memória
+        return poolframes * (NODE_PAGESZ + 2 * sizeof(long) + sizeof(long) + sizeof(bool)) +
+               pagecap * (sizeof(uint16_t) + sizeof(int32_t));
+    }
+    return nodevetsz * sizeof(QuadTreeNode);
+}
@@ -3,182 +3,493 @@
 // A raiz da quadtree é encapsulada
 nodeaddr_t root = INVALIDADDR; // Endereço inválido inicial para a raiz
 long numpoints = 0; // Número de pontos na quadtree
+AttrSummary* summaryvet = NULL; // Resumo dos atributos da subárvore de cada nó interno
+long summaryvetsz = 0; // Tamanho do vetor de resumos
+int32_t* countvet = NULL; // Número de pontos ativos na subárvore de cada nó interno
+const char* pagepath = NULL; // Arquivo de páginas (NULL para nós em memória)
+size_t pagebudget = 0; // Orçamento de memória do pool de páginas
+int splitmode = QUADTREE_SPLIT_MIDPOINT; // Modo de divisão dos nós
 
 // Funções privadas
 static double euclidean_dist(double x1, double y1, double x2, double y2);
 static int cmpknn(const void* a, const void* b);
-static void quadtree_subdivide(nodeaddr_t ad);
-static void quadtree_insert_rec(nodekey_t key, nodeaddr_t curr);
-static nodeaddr_t quadtree_search_rec(nodeaddr_t curr, char* idend, double x, double y);
-static void quadtree_knn_rec(nodeaddr_t curr, double x, double y, long k, Heap* heap);
+static void quadtree_insert_rec(nodekey_t key, nodeaddr_t curr, Boundary bd);
+static nodeaddr_t quadtree_search_rec(nodeaddr_t curr, Boundary bd, char* idend, double x, double y);
+static long quadtree_slot(nodeaddr_t child);
+static AttrSummary quadtree_subtree_summary(const QuadTreeNode* node);
+static int32_t quadtree_subtree_count(const QuadTreeNode* node);
+
+void quadtree_set_paging(const char* path, size_t budget) {
+    pagepath = path;
+    pagebudget = budget;
+}
+
+void quadtree_set_split(int mode) {
+    splitmode = mode;
+}
 
 void quadtree_create(long numnodes, Boundary qt_boundary) {
+    // No modo paginado, os nós ficam no arquivo de páginas e os resumos de
+    // atributos e os contadores de pontos ativos não são mantidos, já que 
+    // ocupariam memória proporcional ao número de nós; os filtros passam a 
+    // ser avaliados ponto a ponto e as subárvores, percorridas
+    if (pagepath != NULL) {
+        node_initialize_paged(pagepath, numnodes, qt_boundary, pagebudget);
+        return;
+    }
+
     // Inicializa o vetor da quadtree
     node_initialize(numnodes, qt_boundary);
+
+    // Inicializa o vetor de resumos, com uma posição por bloco de filhos, 
+    // isto é, por nó interno (ver quadtree_slot)
+    summaryvetsz = numnodes / 4 + 1;
+    summaryvet = (AttrSummary*) malloc(summaryvetsz * sizeof(AttrSummary));
+    if (summaryvet == NULL) {
+        fprintf(stderr,"quadtree_create: could not allocate summaryvet\n");
+        return;
+    }
+    for (long i = 0; i < summaryvetsz; i++) {
+        summaryvet[i] = EMPTYSUMMARY;
+    }
+
+    // Inicializa o vetor de contadores de pontos ativos, com as mesmas 
+    // posições dos resumos
+    countvet = (int32_t*) calloc(summaryvetsz, sizeof(int32_t));
+    if (countvet == NULL) {
+        fprintf(stderr,"quadtree_create: could not allocate countvet\n");
+    }
 }
 
 void quadtree_destroy() {
     // Primeiro desaloca o vetor que contém a quadtree
     node_destroy();
+    free(summaryvet);
+    free(countvet);
+    summaryvet = NULL;
+    countvet = NULL;
+    summaryvetsz = 0;
     // Reseta a raiz da quadtree
     root = INVALIDADDR;
+    numpoints = 0;
 }
 
-// Função auxiliar para subdividir um nó da quadtree em quatro quadrantes
-static void quadtree_subdivide(nodeaddr_t ad)
-{
-    QuadTreeNode curr;
-    // Recupera o nó atual da quadtree a partir do endereço fornecido
-    node_get(ad, &curr);
-
-    // Obtém os limites do nó atual
-    double x_min = curr.boundary.x_min;
-    double x_max = curr.boundary.x_max;
-    double y_min = curr.boundary.y_min;
-    double y_max = curr.boundary.y_max;
-
-    // Define os limites dos quatro novos quadrantes
-    Boundary nw = (Boundary) {x_min, (x_min+x_max)/2, (y_min+y_max)/2, y_max};
-    Boundary ne = (Boundary) {(x_min+x_max)/2, x_max, (y_min+y_max)/2, y_max};
-    Boundary sw = (Boundary) {x_min, (x_min+x_max)/2, y_min, (y_min+y_max)/2};
-    Boundary se = (Boundary) {(x_min+x_max)/2, x_max, y_min, (y_min+y_max)/2};
-    
-    QuadTreeNode aux;
-    // Reseta o nó auxiliar para reutilização
-    node_reset(&aux);
+size_t quadtree_memory() {
+    return node_memory() + summaryvetsz * (sizeof(AttrSummary) + sizeof(int32_t));
+}
+
+// Os resumos de atributos e os contadores de pontos ativos só são mantidos
+// para os nós internos: a subárvore de uma folha é o seu próprio ponto. Os 
+// blocos de quatro filhos são alocados consecutivamente após a raiz, de modo
+// que o endereço do primeiro filho dividido por 4 identifica cada bloco e, 
+// portanto, o nó interno que o criou
+static long quadtree_slot(nodeaddr_t child) {
+    return child / 4;
+}
 
-    // Cria o quadrante noroeste e atualiza o nó atual
-    aux.boundary = nw;
-    curr.nw = node_create(&aux);
+// Funções auxiliares que retornam o resumo dos atributos e o número de 
+// pontos ativos da subárvore do nó
+static AttrSummary quadtree_subtree_summary(const QuadTreeNode* node) {
+    if (node->child != INVALIDADDR) return summaryvet[quadtree_slot(node->child)];
+    if (node->key == INVALIDKEY) return EMPTYSUMMARY;
+    return filter_summary(node->key);
+}
 
-    // Reseta o nó auxiliar e cria o quadrante nordeste
-    node_reset(&aux);
-    aux.boundary = ne;
-    curr.ne = node_create(&aux);
+static int32_t quadtree_subtree_count(const QuadTreeNode* node) {
+    if (node->child != INVALIDADDR) return countvet[quadtree_slot(node->child)];
+    return node->key != INVALIDKEY && station_is_active(node->key);
+}
 
-    // Reseta o nó auxiliar e cria o quadrante sudoeste
-    node_reset(&aux);
-    aux.boundary = sw;
-    curr.sw = node_create(&aux);
+// Função auxiliar para armazenar a chave em um nó vazio, guardando as 
+// coordenadas do ponto como deslocamentos em relação à origem da quadtree
+static void quadtree_set_key(QuadTreeNode* node, nodekey_t key)
+{
+    Item* it = station_get(key);
+    Boundary bd = node_boundary();
+    node->key = key;
+    node->x = (float) (it->x - bd.x_min);
+    node->y = (float) (it->y - bd.y_min);
+}
+
+// Função auxiliar que calcula o ponto (sx, sy) em que o nó, cujos limites são
+// bd, é dividido: o ponto médio de bd ou, nos modos adaptativos, o ponto 
+// armazenado no próprio nó
+static void quadtree_split_point(const QuadTreeNode* node, Boundary* bd, double* sx, double* sy)
+{
+    if (splitmode == QUADTREE_SPLIT_MIDPOINT) {
+        *sx = (bd->x_min + bd->x_max) / 2;
+        *sy = (bd->y_min + bd->y_max) / 2;
+        return;
+    }
+    Boundary origin = node_boundary();
+    *sx = origin.x_min + node->x;
+    *sy = origin.y_min + node->y;
+}
 
-    // Reseta o nó auxiliar e cria o quadrante sudeste
-    node_reset(&aux);
-    aux.boundary = se;
-    curr.se = node_create(&aux);
+// Funções auxiliares que retornam os limites do quadrante q do nó e o 
+// quadrante do nó que contém o ponto (x, y)
+static Boundary quadtree_child_boundary(const QuadTreeNode* node, Boundary* bd, int q)
+{
+    double sx, sy;
+    quadtree_split_point(node, bd, &sx, &sy);
+    return boundary_split(bd, q, sx, sy);
+}
 
-    // Atualiza o nó atual na quadtree com os novos quadrantes
-    node_put(ad, &curr);
+static int quadtree_child_of(const QuadTreeNode* node, Boundary* bd, double x, double y)
+{
+    double sx, sy;
+    quadtree_split_point(node, bd, &sx, &sy);
+    return boundary_split_of(x, y, sx, sy);
 }
 
 // Função auxiliar recursiva para inserir um nó na quadtree
-static void quadtree_insert_rec(nodekey_t key, nodeaddr_t curr)
+static void quadtree_insert_rec(nodekey_t key, nodeaddr_t curr, Boundary bd)
 {
     QuadTreeNode curr_node;
     // Recupera o nó atual da quadtree a partir do endereço fornecido
     node_get(curr, &curr_node);
 
     // Verifica se o ponto está dentro dos limites do nó atual
-    if (!boundary_contains(&curr_node.boundary, key.x, key.y)) {
+    Item* it = station_get(key);
+    if (!boundary_contains(&bd, it->x, it->y)) {
         return; // Se não estiver, retorna 
     }
 
     // Verifica se o nó atual está vazio 
-    if (curr_node.key.idend == NULL) {
+    if (curr_node.key == INVALIDKEY) {
         // Insere a chave no nó atual
-        curr_node.key = key;
+        quadtree_set_key(&curr_node, key);
         node_put(curr, &curr_node);
         numpoints++; // Incrementa o número de pontos na quadtree
         return;
     }
 
-    // Se o nó atual não estiver subdividido, quadtree_subdivide-o
-    if (curr_node.nw == INVALIDADDR) {
-        quadtree_subdivide(curr);
-        // Atualiza o nó atual após a subdivisão
-        node_get(curr, &curr_node);
+    // Se o nó atual não estiver subdividido, cria os quatro quadrantes de uma 
+    // só vez
+    if (curr_node.child == INVALIDADDR) {
+        curr_node.child = node_create_children(curr);
+        node_put(curr, &curr_node);
+        // O nó passa a ser interno, e sua subárvore começa com o seu ponto
+        long slot = quadtree_slot(curr_node.child);
+        if (summaryvet != NULL) summaryvet[slot] = filter_summary(curr_node.key);
+        if (countvet != NULL) countvet[slot] = station_is_active(curr_node.key);
+    }
+
+    // O ponto passa a fazer parte da subárvore do nó atual
+    long slot = quadtree_slot(curr_node.child);
+    if (summaryvet != NULL) {
+        AttrSummary s = filter_summary(key);
+        filter_summary_merge(&summaryvet[slot], &s);
+    }
+    if (countvet != NULL && station_is_active(key)) {
+        countvet[slot]++;
     }
 
-    // Insere recursivamente a chave nos quadrantes apropriados
-    quadtree_insert_rec(key, curr_node.nw);
-    quadtree_insert_rec(key, curr_node.ne);
-    quadtree_insert_rec(key, curr_node.sw);
-    quadtree_insert_rec(key, curr_node.se);
+    // Insere recursivamente a chave no quadrante que contém o ponto
+    int q = quadtree_child_of(&curr_node, &bd, it->x, it->y);
+    quadtree_insert_rec(key, curr_node.child + q, quadtree_child_boundary(&curr_node, &bd, q));
 }
 
 // Função para inserir um nó na quadtree
 void quadtree_insert(nodekey_t key)
 {
-    QuadTreeNode aux;
-    // Reseta o nó auxiliar para reutilização
-    node_reset(&aux);
-    aux.key = key;
-
     // Se a raiz da quadtree estiver vazia, cria a raiz
     if (root == INVALIDADDR) {
+        QuadTreeNode aux;
+        // Reseta o nó auxiliar para reutilização
+        node_reset(&aux);
+        quadtree_set_key(&aux, key);
         root = node_create(&aux);
-        node_put(root, &aux);
         numpoints++; // Incrementa o número de pontos na quadtree
         return;
     }
 
     // Insere a chave na quadtree a partir da raiz
-    quadtree_insert_rec(key, root);
+    quadtree_insert_rec(key, root, node_boundary());
 }
 
 // Função auxiliar recursiva para buscar um nó na quadtree pelo identificador e 
 // coordenadas (x, y)
-static nodeaddr_t quadtree_search_rec(nodeaddr_t curr, char* idend, double x, double y)
+static nodeaddr_t quadtree_search_rec(nodeaddr_t curr, Boundary bd, char* idend, double x, double y)
 {
     QuadTreeNode curr_node;
     // Recupera o nó atual da quadtree a partir do endereço fornecido
     node_get(curr, &curr_node);
 
+    // Um nó vazio não contém o id procurado
+    if (curr_node.key == INVALIDKEY) {
+        return INVALIDADDR;
+    }
+
     // Verifica se o id do nó atual corresponde ao id procurado
-    if (!strcmp(curr_node.key.idend, idend)) {
+    if (!strcmp(station_get(curr_node.key)->idend, idend)) {
         return curr; // Se corresponder, retorna o endereço do nó atual
     }
 
     // Verifica se o nó atual não possui subdivisões (é uma folha)
-    if (curr_node.nw == INVALIDADDR) {
-        return -1; // Se for uma folha, retorna -1 indicando que o nó não foi encontrado
+    if (curr_node.child == INVALIDADDR) {
+        return INVALIDADDR; // Se for uma folha, o nó não foi encontrado
     }
 
-    QuadTreeNode aux;
     // Verifica em qual quadrante o ponto (x, y) está contido e chama a função 
     // recursivamente
-    node_get(curr_node.nw, &aux);
-    if (boundary_contains(&aux.boundary, x, y)) {
-        return quadtree_search_rec(curr_node.nw, idend, x, y);
+    int q = quadtree_child_of(&curr_node, &bd, x, y);
+    Boundary child_bd = quadtree_child_boundary(&curr_node, &bd, q);
+    if (!boundary_contains(&child_bd, x, y)) {
+        // Se o ponto estiver fora dos limites, o id não está na quadtree
+        return INVALIDADDR;
     }
+    return quadtree_search_rec(curr_node.child + q, child_bd, idend, x, y);
+}
 
-    node_get(curr_node.ne, &aux);
-    if (boundary_contains(&aux.boundary, x, y)) {
-        return quadtree_search_rec(curr_node.ne, idend, x, y);
+nodeaddr_t quadtree_search(char* idend, double x, double y)
+{
+    // Verifica se a quadtree está vazia
+    if (root == INVALIDADDR) {
+        fprintf(stderr, "quadtree_search: tree empty\n");
+        return INVALIDADDR; // Se estiver vazia, retorna um endereço inválido
     }
+    // Chama a função recursiva para buscar o nó a partir da raiz
+    return quadtree_search_rec(root, node_boundary(), idend, x, y);
+}
+
+void quadtree_set_active(nodekey_t key, bool ativo)
+{
+    if (countvet == NULL || root == INVALIDADDR) return;
+    // Pontos fora dos limites da quadtree não foram inseridos
+    Item* it = station_get(key);
+    Boundary bd = node_boundary();
+    if (!boundary_contains(&bd, it->x, it->y)) return;
 
-    node_get(curr_node.sw, &aux);
-    if (boundary_contains(&aux.boundary, x, y)) {
-        return quadtree_search_rec(curr_node.sw, idend, x, y);
+    // Atualiza os contadores dos nós internos do caminho da raiz até o nó do
+    // ponto, que é o mesmo caminho percorrido na inserção
+    nodeaddr_t curr = root;
+    while (curr != INVALIDADDR) {
+        QuadTreeNode curr_node;
+        node_get(curr, &curr_node);
+        if (curr_node.child == INVALIDADDR) {
+            return;
+        }
+        countvet[quadtree_slot(curr_node.child)] += ativo ? 1 : -1;
+        if (curr_node.key == key) {
+            return;
+        }
+        int q = quadtree_child_of(&curr_node, &bd, it->x, it->y);
+        bd = quadtree_child_boundary(&curr_node, &bd, q);
+        curr = curr_node.child + q;
     }
+}
 
-    node_get(curr_node.se, &aux);
-    if (boundary_contains(&aux.boundary, x, y)) {
-        return quadtree_search_rec(curr_node.se, idend, x, y);
+// Função recursiva que acumula os pontos ativos da subárvore de curr, cujos 
+// limites são bd, que estão dentro do polígono; inside indica que bd já está
+// inteiramente dentro do polígono. Os identificadores são armazenados em ids
+// (se não for NULL) e sua quantidade em n
+static void quadtree_polygon_rec(nodeaddr_t curr, Boundary bd, const Polygon* poly, bool inside, 
+                                 long* ids, long* n)
+{
+    QuadTreeNode curr_node;
+    node_get(curr, &curr_node);
+    if (curr_node.key == INVALIDKEY) {
+        return;
+    }
+    // Subárvores sem pontos ativos não precisam ser visitadas
+    if (countvet != NULL && quadtree_subtree_count(&curr_node) == 0) {
+        return;
+    }
+    // Subárvores fora do polígono são descartadas
+    if (!inside) {
+        int cls = polygon_classify(poly, &bd);
+        if (cls == POLY_OUTSIDE) return;
+        inside = cls == POLY_INSIDE;
+    }
+    // Se apenas a quantidade é pedida, uma subárvore inteiramente dentro do 
+    // polígono é contada de uma só vez
+    if (inside && ids == NULL && countvet != NULL) {
+        *n += quadtree_subtree_count(&curr_node);
+        return;
     }
+    // O ponto do nó só é testado contra o polígono se o nó cruza a borda
+    if (station_is_active(curr_node.key)) {
+        Item* it = station_get(curr_node.key);
+        if (inside || polygon_contains(poly, it->x, it->y)) {
+            if (ids != NULL) ids[*n] = curr_node.key;
+            (*n)++;
+        }
+    }
+    if (curr_node.child == INVALIDADDR) {
+        return;
+    }
+    for (int q = QUAD_NW; q <= QUAD_SE; q++) {
+        quadtree_polygon_rec(curr_node.child + q, quadtree_child_boundary(&curr_node, &bd, q), poly, inside, ids, n);
+    }
+}
 
-    // Se o id não estiver contido em nenhum quadrante, retorna -1
-    return -1;
+long quadtree_polygon(const Polygon* poly, long* ids)
+{
+    long n = 0;
+    if (root != INVALIDADDR) {
+        quadtree_polygon_rec(root, node_boundary(), poly, false, ids, &n);
+    }
+    return n;
 }
 
-nodeaddr_t quadtree_search(char* idend, double x, double y)
+// Pilha dos segmentos da rota considerados em cada nível da travessia do 
+// corredor: cada nó filtra os segmentos do nó pai para uma fatia acima 
+// deles, que é liberada ao retornar
+typedef struct {
+    long* segs;         // Índices dos segmentos, em fatias por nível
+    long top;           // Fim da fatia mais recente
+    long cap;           // Capacidade do vetor
+} CorridorStack;
+
+// Função recursiva que visita a subárvore curr, de limites bd, considerando
+// apenas os nsegs segmentos da fatia st->segs[first .. first + nsegs), que 
+// são filtrados pela distância à célula antes de serem repassados aos 
+// quadrantes. As fatias são identificadas por posição, já que o vetor pode 
+// ser realocado durante a travessia
+static void quadtree_corridor_rec(nodeaddr_t curr, Boundary bd, const Route* route, double d,
+                                  CorridorStack* st, long first, long nsegs, Neighbor* result, long* n)
 {
-    // Verifica se a quadtree está vazia
+    QuadTreeNode curr_node;
+    node_get(curr, &curr_node);
+    if (curr_node.key == INVALIDKEY) {
+        return;
+    }
+    // Subárvores sem pontos ativos não precisam ser visitadas
+    if (countvet != NULL && quadtree_subtree_count(&curr_node) == 0) {
+        return;
+    }
+    if (st->top + nsegs > st->cap) {
+        while (st->top + nsegs > st->cap) st->cap *= 2;
+        st->segs = (long*) realloc(st->segs, st->cap * sizeof(long));
+    }
+    long kept = st->top;
+    long nkept = 0;
+    for (long i = 0; i < nsegs; i++) {
+        long s = st->segs[first + i];
+        if (route_segment_rect_dist(route, s, &bd) <= d) {
+            st->segs[kept + nkept++] = s;
+        }
+    }
+    // Nenhum ponto da célula está a até d da rota
+    if (nkept == 0) {
+        return;
+    }
+
+    // O ponto do nó está na célula, de modo que os segmentos descartados 
+    // estão a mais de d dele
+    if (station_is_active(curr_node.key)) {
+        Item* it = station_get(curr_node.key);
+        double dist = INFINITY;
+        for (long i = 0; i < nkept; i++) {
+            dist = fmin(dist, route_segment_dist(route, st->segs[kept + i], it->x, it->y));
+        }
+        if (dist <= d) {
+            result[(*n)++] = (Neighbor) {curr_node.key, dist};
+        }
+    }
+    if (curr_node.child == INVALIDADDR) {
+        return;
+    }
+    st->top = kept + nkept;
+    for (int q = QUAD_NW; q <= QUAD_SE; q++) {
+        quadtree_corridor_rec(curr_node.child + q, quadtree_child_boundary(&curr_node, &bd, q), route, d,
+                              st, kept, nkept, result, n);
+    }
+    st->top = kept;
+}
+
+long quadtree_corridor(const Route* route, double d, Neighbor* result)
+{
+    long n = 0;
     if (root == INVALIDADDR) {
-        fprintf(stderr, "quadtree_search: tree empty\n");
-        return INVALIDADDR; // Se estiver vazia, retorna um endereço inválido
+        return 0;
+    }
+    long nsegs = route_segments(route);
+    CorridorStack st = {(long*) malloc(2 * nsegs * sizeof(long)), nsegs, 2 * nsegs};
+    if (st.segs == NULL) {
+        fprintf(stderr,"quadtree_corridor: could not allocate segments\n");
+        return 0;
+    }
+    for (long s = 0; s < nsegs; s++) {
+        st.segs[s] = s;
+    }
+    quadtree_corridor_rec(root, node_boundary(), route, d, &st, 0, nsegs, result, &n);
+    free(st.segs);
+    return n;
+}
+
+// Estado da consulta por janela: o retângulo também é guardado relativo à 
+// origem da quadtree, para que os pontos sejam testados pelas coordenadas 
+// compactas dos nós
+typedef struct {
+    const Boundary* r;  // Retângulo da consulta
+    Boundary rel;       // Retângulo relativo à origem da quadtree
+    double d;           // Distância máxima ao retângulo
+    double tol;         // Erro máximo das distâncias às coordenadas compactas
+    long* ids;          // Identificadores encontrados
+    long n;             // Número de identificadores encontrados
+} WindowQuery;
+
+// Função auxiliar que calcula o quadrado da distância de (x, y) ao retângulo
+// r, zero se o ponto estiver dentro dele
+static double window_dist2(const Boundary* r, double x, double y)
+{
+    double dx = fmax(0, fmax(r->x_min - x, x - r->x_max));
+    double dy = fmax(0, fmax(r->y_min - y, y - r->y_max));
+    return dx * dx + dy * dy;
+}
+
+// Função recursiva que armazena os pontos ativos da subárvore curr, de 
+// limites bd, que estão a até w->d do retângulo; subárvores cuja célula está
+// mais distante ou sem pontos ativos são descartadas. As coordenadas 
+// compactas do nó decidem, sem ler o ponto de recarga, os pontos longe da 
+// borda da janela, e apenas os demais são testados pelas coordenadas exatas
+static void quadtree_window_rec(nodeaddr_t curr, Boundary bd, WindowQuery* w)
+{
+    QuadTreeNode curr_node;
+    node_get(curr, &curr_node);
+    if (curr_node.key == INVALIDKEY) {
+        return;
+    }
+    double dx = fmax(0, fmax(w->r->x_min - bd.x_max, bd.x_min - w->r->x_max));
+    double dy = fmax(0, fmax(w->r->y_min - bd.y_max, bd.y_min - w->r->y_max));
+    if (dx * dx + dy * dy > w->d * w->d) {
+        return;
+    }
+    if (countvet != NULL && quadtree_subtree_count(&curr_node) == 0) {
+        return;
+    }
+    if (station_is_active(curr_node.key)) {
+        double dist = sqrt(window_dist2(&w->rel, curr_node.x, curr_node.y));
+        bool inside = dist <= w->d - w->tol;
+        if (!inside && dist <= w->d + w->tol) {
+            Item* it = station_get(curr_node.key);
+            inside = window_dist2(w->r, it->x, it->y) <= w->d * w->d;
+        }
+        if (inside) {
+            w->ids[w->n++] = curr_node.key;
+        }
+    }
+    if (curr_node.child == INVALIDADDR) {
+        return;
+    }
+    for (int q = QUAD_NW; q <= QUAD_SE; q++) {
+        quadtree_window_rec(curr_node.child + q, quadtree_child_boundary(&curr_node, &bd, q), w);
     }
-    // Chama a função recursiva para buscar o nó a partir da raiz
-    return quadtree_search_rec(root, idend, x, y);
+}
+
+long quadtree_window(const Boundary* r, double d, long* ids)
+{
+    if (root == INVALIDADDR) {
+        return 0;
+    }
+    Boundary origin = node_boundary();
+    WindowQuery w = {r, {r->x_min - origin.x_min, r->x_max - origin.x_min, r->y_min - origin.y_min, 
+                     r->y_max - origin.y_min}, d, 0, ids, 0};
+    w.tol = 2 * fmax(origin.x_max - origin.x_min, origin.y_max - origin.y_min) * 0x1p-24;
+    quadtree_window_rec(root, origin, &w);
+    return w.n;
 }
 
 // Calcula a distancia euclidiana entre (x1,y1) e (x2,y2)
@@ -186,71 +497,174 @@ static double euclidean_dist(double x1, double y1, double x2, double y2) {
 	return sqrt(pow(x2 - x1, 2) + pow(y2 - y1, 2) * 1.0); 
 }
 
-// Função recursiva para encontrar os k nós mais próximos na quadtree
-static void quadtree_knn_rec(nodeaddr_t curr, double x, double y, long k, Heap* heap)
-{	
-    // Verifica se o nó atual é inválido
-    if (curr == INVALIDADDR) {
-        return;
-    }
+// Quadro da travessia explícita de uma consulta kNN: um nó cujos quadrantes
+// ainda estão sendo visitados
+typedef struct {
+    nodeaddr_t child;   // Endereço do primeiro filho do nó
+    Boundary bd;        // Limites do nó
+    double sx;          // Coordenada x do ponto de divisão do nó
+    double sy;          // Coordenada y do ponto de divisão do nó
+    int q;              // Próximo quadrante a ser considerado
+    int skip;           // Quadrantes descartados pelo filtro (um bit cada)
+} KnnFrame;
+
+// Estado de uma consulta kNN em andamento. A travessia em profundidade é 
+// feita com uma pilha explícita, de modo que a consulta pode ser suspensa 
+// sempre que precisa de um nó e retomada depois, quando o nó (cuja leitura 
+// foi antecipada) já está na cache
+typedef struct {
+    double x;           // Coordenada x da consulta
+    double y;           // Coordenada y da consulta
+    long k;             // Número de vizinhos
+    const Filter* filter; // Filtro de atributos (NULL para nenhum)
+    Heap* heap;         // Vizinhos encontrados até o momento
+    KnnFrame* stack;    // Pilha de nós em visita
+    long depth;         // Número de quadros na pilha
+    long stackcap;      // Capacidade da pilha
+    nodeaddr_t next;    // Próximo nó a ser visitado (INVALIDADDR se nenhum)
+    Boundary nextbd;    // Limites do próximo nó
+    double qx;          // Deslocamento x da consulta em relação à origem
+    double qy;          // Deslocamento y da consulta em relação à origem
+    double tol;         // Erro máximo das distâncias às coordenadas compactas
+} KnnState;
+
+// Função auxiliar que inicia a consulta s a partir da raiz. A pilha de s é
+// reaproveitada entre consultas
+static void knn_start(KnnState* s, double x, double y, long k, const Filter* filter) {
+    s->x = x;
+    s->y = y;
+    s->k = k;
+    s->filter = filter;
+    s->heap = heap_initialize(k);
+    s->depth = 0;
+    s->next = root;
+    s->nextbd = node_boundary();
+    // Cada coordenada compacta difere da exata em no máximo meia unidade na
+    // última casa do float, isto é, 2^-24 do maior deslocamento possível; a
+    // distância, em no máximo raiz de 2 vezes isso (arredondado para 2)
+    Boundary origin = s->nextbd;
+    s->qx = x - origin.x_min;
+    s->qy = y - origin.y_min;
+    s->tol = 2 * fmax(origin.x_max - origin.x_min, origin.y_max - origin.y_min) * 0x1p-24;
+}
+
+// Função auxiliar que visita o próximo nó da consulta: atualiza o heap com o
+// ponto do nó e, se ele tiver filhos, empilha o nó para que seus quadrantes 
+// sejam considerados
+static void knn_visit(KnnState* s) {
+    nodeaddr_t curr = s->next;
+    s->next = INVALIDADDR;
 
     QuadTreeNode curr_node;
     // Recupera o nó atual da quadtree a partir do endereço fornecido
     node_get(curr, &curr_node);
 
     // Verifica se o nó atual está vazio
-    if (curr_node.key.idend == NULL) {
+    if (curr_node.key == INVALIDKEY) {
+        return;
+    }
+
+    // Descarta a subárvore de um nó interno se nenhum de seus pontos pode 
+    // satisfazer o filtro; o ponto de uma folha é verificado a seguir
+    if (summaryvet != NULL && curr_node.child != INVALIDADDR &&
+        !filter_may_match(s->filter, &summaryvet[quadtree_slot(curr_node.child)])) {
         return;
     }
     
-    // Calcula a distância euclidiana entre o ponto (x, y) e o nó atual
-    double dist = euclidean_dist(x, y, curr_node.key.x, curr_node.key.y);
-    
-    // Se o heap ainda não estiver cheio e o nó atual estiver ativo, adiciona o 
-    // nó ao heap
-    if (heap->size < k && curr_node.key.ativo) {
-        heap_push(heap, (Neighbor) {curr, dist});
-    }
-    // Se a distância do nó atual for menor que a maior distância no heap e o 
-    // nó atual estiver ativo, substitui o nó no heap
-    else if (dist < heap->neighbors[0].dist && curr_node.key.ativo) {
-        heap_pop(heap);
-        heap_push(heap, (Neighbor) {curr, dist});
-    }
-
-    QuadTreeNode aux;
-    // Verifica se o quadrante noroeste pode conter um ponto mais próximo e 
-    // chama a função recursivamente
-    if (curr_node.nw != INVALIDADDR) {
-        node_get(curr_node.nw, &aux);
-        if (heap->size < k || can_contain_closer_point(&aux.boundary, x, y, heap->neighbors[0].dist)) {
-            quadtree_knn_rec(curr_node.nw, x, y, k, heap);
-        }
+    // O heap guarda distâncias exatas, para que vizinhos quase empatados 
+    // sejam ordenados e descartados como na busca exata. A distância às 
+    // coordenadas compactas do nó descarta, sem ler o ponto de recarga, os 
+    // candidatos mais distantes que o k-ésimo vizinho mesmo descontado o erro
+    // de arredondamento, antes mesmo de verificar o status e o filtro; os 
+    // demais têm a distância exata calculada
+    Heap* heap = s->heap;
+    bool ativo = true;
+    if (heap->size == s->k) {
+        double dx = curr_node.x - s->qx, dy = curr_node.y - s->qy;
+        double limit = heap->neighbors[0].dist + s->tol;
+        ativo = dx * dx + dy * dy < limit * limit;
     }
-    // Verifica se o quadrante nordeste pode conter um ponto mais próximo e 
-    // chama a função recursivamente
-    if (curr_node.ne != INVALIDADDR) {
-        node_get(curr_node.ne, &aux);
-        if (heap->size < k || can_contain_closer_point(&aux.boundary, x, y, heap->neighbors[0].dist)) {
-            quadtree_knn_rec(curr_node.ne, x, y, k, heap);
+    ativo = ativo && filter_match(s->filter, curr_node.key) && station_is_active(curr_node.key);
+    if (ativo) {
+        Item* it = station_get(curr_node.key);
+        double dist = euclidean_dist(s->x, s->y, it->x, it->y);
+
+        // Se o heap ainda não estiver cheio, adiciona o ponto ao heap
+        if (heap->size < s->k) {
+            heap_push(heap, (Neighbor) {curr_node.key, dist});
+        }
+        // Se a distância do ponto for menor que a maior distância no heap, 
+        // substitui o ponto no heap
+        else if (dist < heap->neighbors[0].dist) {
+            heap_pop(heap);
+            heap_push(heap, (Neighbor) {curr_node.key, dist});
         }
     }
-    // Verifica se o quadrante sudoeste pode conter um ponto mais próximo e 
-    // chama a função recursivamente
-    if (curr_node.sw != INVALIDADDR) {
-        node_get(curr_node.sw, &aux);
-        if (heap->size < k || can_contain_closer_point(&aux.boundary, x, y, heap->neighbors[0].dist)) {
-            quadtree_knn_rec(curr_node.sw, x, y, k, heap);
+
+    // Nós folha não possuem quadrantes a visitar
+    if (curr_node.child == INVALIDADDR) {
+        return;
+    }
+    if (s->depth == s->stackcap) {
+        s->stackcap = s->stackcap > 0 ? 2 * s->stackcap : 32;
+        s->stack = (KnnFrame*) realloc(s->stack, s->stackcap * sizeof(KnnFrame));
+    }
+    KnnFrame f = {curr_node.child, s->nextbd, 0, 0, QUAD_NW, 0};
+    quadtree_split_point(&curr_node, &f.bd, &f.sx, &f.sy);
+
+    // Com filtro, os quatro filhos, que ocupam um só bloco, são examinados de
+    // uma vez: os vazios e os internos cujo resumo não satisfaz o filtro são
+    // descartados sem serem visitados. As folhas não têm resumo próprio, e a
+    // leitura dos códigos de seus pontos é antecipada
+    if (summaryvet != NULL && s->filter != NULL) {
+        for (int q = QUAD_NW; q <= QUAD_SE; q++) {
+            QuadTreeNode child_node;
+            node_get(curr_node.child + q, &child_node);
+            if (child_node.key == INVALIDKEY) {
+                f.skip |= 1 << q;
+            }
+            else if (child_node.child == INVALIDADDR) {
+                filter_prefetch(s->filter, child_node.key);
+            }
+            else if (!filter_may_match(s->filter, &summaryvet[quadtree_slot(child_node.child)])) {
+                f.skip |= 1 << q;
+            }
         }
     }
-    // Verifica se o quadrante sudeste pode conter um ponto mais próximo e 
-    // chama a função recursivamente
-    if (curr_node.se != INVALIDADDR) {
-        node_get(curr_node.se, &aux);
-        if (heap->size < k || can_contain_closer_point(&aux.boundary, x, y, heap->neighbors[0].dist)) {
-            quadtree_knn_rec(curr_node.se, x, y, k, heap);
+    s->stack[s->depth++] = f;
+}
+
+// Função auxiliar que avança a consulta s até o próximo nó a ser visitado, 
+// cuja leitura é antecipada. Retorna false quando a consulta termina
+static bool knn_advance(KnnState* s) {
+    if (s->next != INVALIDADDR) {
+        knn_visit(s);
+    }
+    Heap* heap = s->heap;
+    while (s->depth > 0) {
+        KnnFrame* f = &s->stack[s->depth - 1];
+        if (f->q > QUAD_SE) {
+            s->depth--;
+            continue;
+        }
+        // Para cada quadrante (nw, ne, sw, se), verifica se ele pode conter um
+        // ponto mais próximo, considerando os vizinhos encontrados nos 
+        // quadrantes anteriores
+        if (f->skip & (1 << f->q)) {
+            f->q++;
+            continue;
+        }
+        Boundary child_bd = boundary_split(&f->bd, f->q, f->sx, f->sy);
+        nodeaddr_t child = f->child + f->q;
+        f->q++;
+        if (heap->size < s->k || can_contain_closer_point(&child_bd, s->x, s->y, heap->neighbors[0].dist)) {
+            s->next = child;
+            s->nextbd = child_bd;
+            node_prefetch(child);
+            return true;
         }
     }
+    return s->next != INVALIDADDR;
 }
 
 // Função de comparação para o KNN
@@ -263,27 +677,575 @@ static int cmpknn(const void* a, const void* b) {
     else return 0;
 }
 
-void quadtree_knn(double x, double y, long k, Neighbor* result)
+// Função auxiliar que conclui a consulta s, armazenando os vizinhos em result
+// e retornando quantos foram encontrados
+static long knn_finish(KnnState* s, Neighbor* result) {
+    Heap* heap = s->heap;
+
+    // Ordena os vizinhos encontrados pela distância
+    qsort(heap->neighbors, heap->size, sizeof(Neighbor), cmpknn);
+    
+    // Copia os vizinhos ordenados para o array de resultados
+	memcpy(result, heap->neighbors, heap->size * sizeof(Neighbor));
+    long found = heap->size;
+    heap_destroy(heap);
+    s->heap = NULL;
+    return found;
+}
+
+long quadtree_knn(double x, double y, long k, const Filter* filter, Neighbor* result)
 {
     // Verifica se a quadtree está vazia
     if (root == INVALIDADDR) {
         fprintf(stderr,"quadtree_search: tree empty\n");
+        return 0;
+    }
+    // Percorre a quadtree a partir da raiz, um nó de cada vez
+    KnnState s = {0};
+    knn_start(&s, x, y, k, filter);
+    while (knn_advance(&s));
+    long found = knn_finish(&s, result);
+    free(s.stack);
+    return found;
+}
+
+void quadtree_knn_batch(const double* xs, const double* ys, const long* ks, long nq, Neighbor** result, long* found)
+{
+    // Verifica se a quadtree está vazia
+    if (root == INVALIDADDR) {
+        fprintf(stderr,"quadtree_search: tree empty\n");
+        memset(found, 0, nq * sizeof(long));
         return;
     }
-    // Inicializa um heap para armazenar os k vizinhos mais próximos
-    Heap* heap = heap_initialize(k);
-    // Chama a função recursiva para encontrar os k vizinhos mais próximos a 
-    // partir da raiz
-    quadtree_knn_rec(root, x, y, k, heap);
+    // Cada posição mantém uma consulta em andamento; query[i] é o índice da
+    // consulta na posição i, ou -1 se a posição estiver livre
+    KnnState slots[QUADTREE_INFLIGHT] = {0};
+    long query[QUADTREE_INFLIGHT];
+    long nextq = 0;
+    long active = 0;
+    for (int i = 0; i < QUADTREE_INFLIGHT; i++) {
+        query[i] = nextq < nq ? nextq++ : -1;
+        if (query[i] < 0) continue;
+        knn_start(&slots[i], xs[query[i]], ys[query[i]], ks[query[i]], NULL);
+        active++;
+    }
 
-    // Ordena os vizinhos encontrados pela distância
-    qsort(heap->neighbors, k, sizeof(Neighbor), cmpknn);
-    
-    // Copia os vizinhos ordenados para o array de resultados
-	memcpy(result, heap->neighbors, k * sizeof(Neighbor));
+    // Cada consulta avança até precisar de um nó, cuja leitura é antecipada,
+    // e cede a vez à consulta seguinte; quando a vez volta a ela, o nó já 
+    // deve estar na cache
+    while (active > 0) {
+        for (int i = 0; i < QUADTREE_INFLIGHT; i++) {
+            if (query[i] < 0 || knn_advance(&slots[i])) continue;
+            // A consulta terminou e a posição recebe a próxima consulta
+            found[query[i]] = knn_finish(&slots[i], result[query[i]]);
+            query[i] = nextq < nq ? nextq++ : -1;
+            if (query[i] < 0) {
+                active--;
+                continue;
+            }
+            knn_start(&slots[i], xs[query[i]], ys[query[i]], ks[query[i]], NULL);
+        }
+    }
+    for (int i = 0; i < QUADTREE_INFLIGHT; i++) {
+        free(slots[i].stack);
+    }
+}
+
+// Nó da árvore de consultas usada na junção: um intervalo de consultas 
+// consecutivas (em ordem espacial) e o retângulo que as envolve
+typedef struct {
+    long lo;            // Primeira consulta do intervalo
+    long hi;            // Fim (exclusivo) do intervalo
+    Boundary bb;        // Retângulo envolvente das consultas
+    double bound;       // Maior distância do k-ésimo vizinho das consultas
+    long left;          // Filho esquerdo (-1 se for folha)
+    long right;         // Filho direito
+} JoinNode;
+
+// Estado de uma junção em andamento
+typedef struct {
+    const double* xs;   // Coordenadas x das consultas
+    const double* ys;   // Coordenadas y das consultas
+    long k;             // Número de vizinhos por consulta
+    Heap* heaps;        // Heap de vizinhos de cada consulta
+    JoinNode* nodes;    // Nós da árvore de consultas
+    long numnodes;      // Número de nós da árvore de consultas
+} Join;
+
+// Número máximo de consultas em uma folha da árvore de consultas
+#define JOIN_LEAF 8
+
+// Função auxiliar que constrói a árvore de consultas sobre [lo, hi), 
+// dividindo o intervalo ao meio, e retorna o índice do nó criado
+static long join_build(Join* j, long lo, long hi) {
+    long n = j->numnodes++;
+    JoinNode* node = &j->nodes[n];
+    node->lo = lo;
+    node->hi = hi;
+    node->bound = INFINITY;
+    node->bb = (Boundary) {INFINITY, -INFINITY, INFINITY, -INFINITY};
+    for (long i = lo; i < hi; i++) {
+        node->bb.x_min = fmin(node->bb.x_min, j->xs[i]);
+        node->bb.x_max = fmax(node->bb.x_max, j->xs[i]);
+        node->bb.y_min = fmin(node->bb.y_min, j->ys[i]);
+        node->bb.y_max = fmax(node->bb.y_max, j->ys[i]);
+    }
+    node->left = node->right = -1;
+    if (hi - lo > JOIN_LEAF) {
+        long mid = lo + (hi - lo) / 2;
+        long left = join_build(j, lo, mid);
+        long right = join_build(j, mid, hi);
+        // O vetor de nós não é realocado, então o ponteiro continua válido
+        node->left = left;
+        node->right = right;
+    }
+    return n;
+}
+
+// Função auxiliar que calcula a menor distância entre dois retângulos
+static double join_rect_dist(Boundary* a, Boundary* b) {
+    double dx = fmax(fmax(a->x_min - b->x_max, b->x_min - a->x_max), 0);
+    double dy = fmax(fmax(a->y_min - b->y_max, b->y_min - a->y_max), 0);
+    return sqrt(dx * dx + dy * dy);
+}
+
+// Função auxiliar que considera o ponto de recarga key para as consultas do 
+// nó q e atualiza o limite do nó
+static void join_visit_point(Join* j, JoinNode* q, nodekey_t key) {
+    Item* it = station_get(key);
+    bool ativo = station_is_active(key);
+    double bound = 0;
+    for (long i = q->lo; i < q->hi; i++) {
+        Heap* heap = &j->heaps[i];
+        if (ativo) {
+            double dist = euclidean_dist(j->xs[i], j->ys[i], it->x, it->y);
+            if (heap->size < j->k) {
+                heap_push(heap, (Neighbor) {key, dist});
+            }
+            else if (dist < heap->neighbors[0].dist) {
+                heap_pop(heap);
+                heap_push(heap, (Neighbor) {key, dist});
+            }
+        }
+        bound = fmax(bound, heap->size < j->k ? INFINITY : heap->neighbors[0].dist);
+    }
+    q->bound = bound;
+}
+
+// Função recursiva da junção entre o nó qn da árvore de consultas e a 
+// subárvore da quadtree com raiz em r, cujos limites são bd. A cada passo é 
+// dividido o lado com o maior retângulo, de modo que a poda é compartilhada 
+// pelas consultas próximas
+static void join_rec(Join* j, long qn, nodeaddr_t r, Boundary bd) {
+    JoinNode* q = &j->nodes[qn];
+    // Nenhuma consulta do nó pode ter um vizinho mais próximo na subárvore
+    if (join_rect_dist(&q->bb, &bd) >= q->bound) return;
+
+    QuadTreeNode node;
+    node_get(r, &node);
+    if (node.key == INVALIDKEY) return;
+
+    double qarea = (q->bb.x_max - q->bb.x_min) * (q->bb.y_max - q->bb.y_min);
+    double rarea = (bd.x_max - bd.x_min) * (bd.y_max - bd.y_min);
+    bool leaf = q->left < 0;
+
+    if (leaf || node.child == INVALIDADDR || rarea > qarea) {
+        // Divide a quadtree: o ponto do nó é considerado para todas as 
+        // consultas e os quadrantes são visitados do mais próximo ao mais 
+        // distante do retângulo das consultas
+        join_visit_point(j, q, node.key);
+        if (node.child == INVALIDADDR) return;
+        Boundary child_bd[4];
+        double dist[4];
+        int order[4];
+        for (int c = QUAD_NW; c <= QUAD_SE; c++) {
+            child_bd[c] = quadtree_child_boundary(&node, &bd, c);
+            dist[c] = join_rect_dist(&q->bb, &child_bd[c]);
+            // Ordenação por inserção dos quadrantes pela distância
+            int p = c;
+            while (p > 0 && dist[order[p - 1]] > dist[c]) {
+                order[p] = order[p - 1];
+                p--;
+            }
+            order[p] = c;
+        }
+        for (int c = 0; c < 4; c++) {
+            join_rec(j, qn, node.child + order[c], child_bd[order[c]]);
+            q = &j->nodes[qn];
+            // Os limites dos filhos também são limites válidos para o nó
+            if (!leaf) {
+                q->bound = fmin(q->bound, fmax(j->nodes[q->left].bound, j->nodes[q->right].bound));
+            }
+        }
+        return;
+    }
+
+    // Divide as consultas, visitando primeiro o filho mais próximo
+    long first = q->left, second = q->right;
+    if (join_rect_dist(&j->nodes[second].bb, &bd) < join_rect_dist(&j->nodes[first].bb, &bd)) {
+        first = q->right;
+        second = q->left;
+    }
+    join_rec(j, first, r, bd);
+    join_rec(j, second, r, bd);
+    q = &j->nodes[qn];
+    q->bound = fmin(q->bound, fmax(j->nodes[q->left].bound, j->nodes[q->right].bound));
+}
+
+void quadtree_knn_join(const double* xs, const double* ys, long nq, long k, Neighbor* result, long* found) {
+    if (nq <= 0) return;
+    Join j = {xs, ys, k, NULL, NULL, 0};
+    j.heaps = (Heap*) malloc(nq * sizeof(Heap));
+    // Como só são divididos intervalos com mais de JOIN_LEAF consultas, as 
+    // folhas têm ao menos JOIN_LEAF / 2 consultas
+    j.nodes = (JoinNode*) malloc(2 * (nq / (JOIN_LEAF / 2) + 1) * sizeof(JoinNode));
+    if (j.heaps == NULL || j.nodes == NULL) {
+        fprintf(stderr,"quadtree_knn_join: could not allocate join\n");
+        free(j.heaps);
+        free(j.nodes);
+        return;
+    }
+    // O heap de cada consulta ocupa a sua parte do vetor de resultados
+    for (long i = 0; i < nq; i++) {
+        j.heaps[i] = (Heap) {0, &result[i * k]};
+    }
+    join_build(&j, 0, nq);
+
+    if (root != INVALIDADDR && k > 0) {
+        join_rec(&j, 0, root, node_boundary());
+    }
+
+    // Ordena os vizinhos de cada consulta pela distância
+    for (long i = 0; i < nq; i++) {
+        qsort(j.heaps[i].neighbors, j.heaps[i].size, sizeof(Neighbor), cmpknn);
+        found[i] = j.heaps[i].size;
+    }
+    free(j.heaps);
+    free(j.nodes);
+}
+
+// Entrada da fronteira de um cursor: a subárvore de um nó ou o ponto
+// armazenado no próprio nó
+typedef struct {
+    double dist;        // Distância mínima de (x, y) à subárvore ou ao ponto
+    nodeaddr_t addr;    // Endereço do nó
+    bool point;         // Indica se a entrada é o ponto do nó
+    Boundary bd;        // Limites do nó
+} CursorEntry;
+
+// Cursor de vizinhos mais próximos: a fronteira da busca em ordem de 
+// distância é mantida entre as chamadas em um heap mínimo
+struct QuadTreeCursor {
+    double x;           // Coordenada x da consulta
+    double y;           // Coordenada y da consulta
+    Filter filter;      // Filtro aplicado aos pontos
+    bool filtered;      // Indica se há filtro
+    CursorEntry* heap;  // Heap mínimo de entradas, pela distância
+    long size;          // Número de entradas no heap
+    long capacity;      // Capacidade do heap
+};
+
+// Função auxiliar que insere uma entrada no heap mínimo do cursor
+static void cursor_push(QuadTreeCursor* c, CursorEntry e) {
+    if (c->size == c->capacity) {
+        c->capacity = c->capacity ? 2 * c->capacity : 64;
+        c->heap = (CursorEntry*) realloc(c->heap, c->capacity * sizeof(CursorEntry));
+    }
+    // Sobe a entrada até que o pai tenha distância menor ou igual
+    long i = c->size++;
+    while (i > 0 && c->heap[(i - 1) / 2].dist > e.dist) {
+        c->heap[i] = c->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    c->heap[i] = e;
+}
+
+// Função auxiliar que remove a entrada de menor distância do heap do cursor
+static CursorEntry cursor_pop(QuadTreeCursor* c) {
+    CursorEntry top = c->heap[0];
+    CursorEntry last = c->heap[--c->size];
+    // Desce a última entrada a partir da raiz
+    long i = 0;
+    while (2 * i + 1 < c->size) {
+        long child = 2 * i + 1;
+        if (child + 1 < c->size && c->heap[child + 1].dist < c->heap[child].dist) child++;
+        if (c->heap[child].dist >= last.dist) break;
+        c->heap[i] = c->heap[child];
+        i = child;
+    }
+    c->heap[i] = last;
+    return top;
+}
+
+QuadTreeCursor* quadtree_cursor_open(double x, double y, const Filter* filter) {
+    QuadTreeCursor* c = (QuadTreeCursor*) calloc(1, sizeof(QuadTreeCursor));
+    if (c == NULL) {
+        fprintf(stderr,"quadtree_cursor_open: could not allocate cursor\n");
+        return NULL;
+    }
+    c->x = x;
+    c->y = y;
+    c->filtered = filter != NULL;
+    if (filter != NULL) c->filter = *filter;
+    // A fronteira começa com a subárvore da raiz
+    if (root != INVALIDADDR) {
+        Boundary bd = node_boundary();
+        cursor_push(c, (CursorEntry) {boundary_min_dist(&bd, x, y), root, false, bd});
+    }
+    return c;
+}
+
+long quadtree_cursor_next(QuadTreeCursor* c, long k, Neighbor* result) {
+    const Filter* filter = c->filtered ? &c->filter : NULL;
+    long found = 0;
+    while (found < k && c->size > 0) {
+        CursorEntry e = cursor_pop(c);
+        QuadTreeNode node;
+        node_get(e.addr, &node);
+
+        if (e.point) {
+            // Nenhuma entrada restante está mais próxima que este ponto; o 
+            // status de atividade é verificado apenas quando ele é alcançado
+            if (station_is_active(node.key)) {
+                result[found++] = (Neighbor) {node.key, e.dist};
+            }
+            continue;
+        }
+
+        // Expande a subárvore: o ponto do nó e os quadrantes que podem conter
+        // pontos que satisfazem o filtro entram na fronteira
+        if (node.key == INVALIDKEY) {
+            continue;
+        }
+        if (summaryvet != NULL && node.child != INVALIDADDR && 
+            !filter_may_match(filter, &summaryvet[quadtree_slot(node.child)])) {
+            continue;
+        }
+        if (filter_match(filter, node.key)) {
+            Item* it = station_get(node.key);
+            cursor_push(c, (CursorEntry) {euclidean_dist(c->x, c->y, it->x, it->y), e.addr, true, e.bd});
+        }
+        if (node.child == INVALIDADDR) continue;
+        for (int q = QUAD_NW; q <= QUAD_SE; q++) {
+            Boundary child_bd = quadtree_child_boundary(&node, &e.bd, q);
+            double dist = boundary_min_dist(&child_bd, c->x, c->y);
+            cursor_push(c, (CursorEntry) {dist, node.child + q, false, child_bd});
+        }
+    }
+    return found;
+}
+
+void quadtree_cursor_close(QuadTreeCursor* c) {
+    if (c == NULL) return;
+    free(c->heap);
+    free(c);
+}
+
+// Função auxiliar que retorna o k-ésimo menor valor de v[0..n), reordenando
+// v (seleção rápida)
+static double select_kth(double* v, long n, long k) {
+    long lo = 0, hi = n - 1;
+    while (lo < hi) {
+        double pivot = v[lo + (hi - lo) / 2];
+        long i = lo, j = hi;
+        while (i <= j) {
+            while (v[i] < pivot) i++;
+            while (v[j] > pivot) j--;
+            if (i <= j) {
+                double t = v[i];
+                v[i++] = v[j];
+                v[j--] = t;
+            }
+        }
+        if (k <= j) hi = j;
+        else if (k >= i) lo = i;
+        else break;
+    }
+    return v[k];
+}
+
+// Função auxiliar que escolhe, entre os pontos keys[0..n), o ponto mais 
+// próximo da mediana (ou do centroide) de suas coordenadas e retorna sua 
+// posição; scratch deve ter espaço para n valores
+static long quadtree_pick_split(nodekey_t* keys, long n, double* scratch) {
+    double cx = 0, cy = 0;
+    if (splitmode == QUADTREE_SPLIT_CENTROID) {
+        for (long i = 0; i < n; i++) {
+            Item* it = station_get(keys[i]);
+            cx += it->x;
+            cy += it->y;
+        }
+        cx /= n;
+        cy /= n;
+    }
+    else {
+        for (long i = 0; i < n; i++) scratch[i] = station_get(keys[i])->x;
+        cx = select_kth(scratch, n, n / 2);
+        for (long i = 0; i < n; i++) scratch[i] = station_get(keys[i])->y;
+        cy = select_kth(scratch, n, n / 2);
+    }
+    long best = 0;
+    double bestdist = INFINITY;
+    for (long i = 0; i < n; i++) {
+        Item* it = station_get(keys[i]);
+        double d = (it->x - cx) * (it->x - cx) + (it->y - cy) * (it->y - cy);
+        if (d < bestdist) {
+            bestdist = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Função auxiliar que move para o início de keys[0..n) os pontos cujo 
+// quadrante no nó não tem o bit mask, retornando quantos são
+static long quadtree_partition(nodekey_t* keys, long n, const QuadTreeNode* node, Boundary* bd, int mask) {
+    long i = 0, j = n - 1;
+    while (i <= j) {
+        Item* it = station_get(keys[i]);
+        if (!(quadtree_child_of(node, bd, it->x, it->y) & mask)) {
+            i++;
+            continue;
+        }
+        nodekey_t t = keys[i];
+        keys[i] = keys[j];
+        keys[j--] = t;
+    }
+    return i;
+}
+
+// Função recursiva que constrói a subárvore do nó vazio curr, cujos limites 
+// são bd, sobre os pontos keys[0..n): o ponto escolhido por 
+// quadtree_pick_split fica no nó e os demais são divididos entre os 
+// quadrantes definidos por ele
+static void quadtree_build_rec(nodeaddr_t curr, Boundary bd, nodekey_t* keys, long n, double* scratch)
+{
+    long s = quadtree_pick_split(keys, n, scratch);
+    nodekey_t t = keys[0];
+    keys[0] = keys[s];
+    keys[s] = t;
+
+    QuadTreeNode curr_node;
+    node_get(curr, &curr_node);
+    quadtree_set_key(&curr_node, keys[0]);
+    numpoints++;
+    if (n == 1) {
+        node_put(curr, &curr_node);
+        return;
+    }
+    curr_node.child = node_create_children(curr);
+    node_put(curr, &curr_node);
+    long slot = quadtree_slot(curr_node.child);
+    if (summaryvet != NULL) summaryvet[slot] = filter_summary(keys[0]);
+    if (countvet != NULL) countvet[slot] = station_is_active(keys[0]);
+
+    // Divide os pontos restantes entre os quadrantes, na ordem nw, ne, sw, se:
+    // primeiro norte e sul, depois oeste e leste em cada metade
+    nodekey_t* rest = keys + 1;
+    long m = n - 1;
+    long north = quadtree_partition(rest, m, &curr_node, &bd, 2);
+    long nw = quadtree_partition(rest, north, &curr_node, &bd, 1);
+    long sw = quadtree_partition(rest + north, m - north, &curr_node, &bd, 1);
+    long start[5] = {0, nw, north, north + sw, m};
+    for (int q = QUAD_NW; q <= QUAD_SE; q++) {
+        if (start[q + 1] == start[q]) continue;
+        nodeaddr_t child = curr_node.child + q;
+        quadtree_build_rec(child, quadtree_child_boundary(&curr_node, &bd, q), rest + start[q], 
+                           start[q + 1] - start[q], scratch);
+        // Acrescenta a subárvore do quadrante à do nó
+        QuadTreeNode child_node;
+        node_get(child, &child_node);
+        if (summaryvet != NULL) {
+            AttrSummary cs = quadtree_subtree_summary(&child_node);
+            filter_summary_merge(&summaryvet[slot], &cs);
+        }
+        if (countvet != NULL) countvet[slot] += quadtree_subtree_count(&child_node);
+    }
 }
 
-void export_node(nodeaddr_t addr, FILE* file) {
+void quadtree_bulk_build(Boundary bd)
+{
+    long n = station_count();
+    // Cada nó interno cria quatro nós, e há menos nós internos que pontos
+    quadtree_create(4 * n - 1, bd);
+
+    // Pontos fora dos limites não são inseridos, assim como em quadtree_insert
+    nodekey_t* keys = (nodekey_t*) malloc((n > 0 ? n : 1) * sizeof(nodekey_t));
+    double* scratch = (double*) malloc((n > 0 ? n : 1) * sizeof(double));
+    long m = 0;
+    for (long i = 0; i < n; i++) {
+        Item* it = station_get(i);
+        if (boundary_contains(&bd, it->x, it->y)) keys[m++] = (nodekey_t) i;
+    }
+    if (m > 0) {
+        QuadTreeNode aux;
+        node_reset(&aux);
+        root = node_create(&aux);
+        quadtree_build_rec(root, bd, keys, m, scratch);
+    }
+    free(keys);
+    free(scratch);
+}
+
+// Adaptadores da quadtree para a interface de índice espacial
+static void quadtree_index_build(Boundary bd) {
+    // Nos modos adaptativos, a quadtree é construída de uma só vez, já que o
+    // ponto de cada nó depende de todos os pontos de sua célula
+    if (splitmode != QUADTREE_SPLIT_MIDPOINT) {
+        quadtree_bulk_build(bd);
+        return;
+    }
+    long n = station_count();
+    // Cada inserção cria no máximo quatro nós além da raiz
+    quadtree_create(4 * n - 1, bd);
+    for (long i = 0; i < n; i++) {
+        quadtree_insert((nodekey_t) i);
+    }
+}
+
+static long quadtree_index_search(char* idend, double x, double y) {
+    nodeaddr_t addr = quadtree_search(idend, x, y);
+    if (addr == INVALIDADDR) return INVALIDSTATION;
+    QuadTreeNode node;
+    node_get(addr, &node);
+    return node.key;
+}
+
+static void* quadtree_index_cursor_open(double x, double y, const Filter* filter) {
+    return quadtree_cursor_open(x, y, filter);
+}
+
+static long quadtree_index_cursor_next(void* cursor, long k, Neighbor* result) {
+    return quadtree_cursor_next((QuadTreeCursor*) cursor, k, result);
+}
+
+static void quadtree_index_cursor_close(void* cursor) {
+    quadtree_cursor_close((QuadTreeCursor*) cursor);
+}
+
+static void quadtree_index_set_active(long id, bool ativo) {
+    quadtree_set_active((nodekey_t) id, ativo);
+}
+
+const SpatialIndex quadtree_index = {
+    "quadtree",
+    quadtree_index_build,
+    quadtree_destroy,
+    quadtree_index_set_active,
+    quadtree_index_search,
+    quadtree_knn,
+    quadtree_knn_join,
+    quadtree_knn_batch,
+    quadtree_index_cursor_open,
+    quadtree_index_cursor_next,
+    quadtree_index_cursor_close,
+    quadtree_polygon,
+    quadtree_corridor,
+    quadtree_window,
+    quadtree_memory
+};
+
+void export_node(nodeaddr_t addr, Boundary bd, FILE* file) {
     // Verifica se o endereço do nó é inválido
     if (addr == INVALIDADDR) return;
 
@@ -292,13 +1254,13 @@ void export_node(nodeaddr_t addr, FILE* file) {
     node_get(addr, &node);
 
     // Escreve os limites do nó atual no arquivo
-    fprintf(file, "%f %f %f %f\n", node.boundary.x_min, node.boundary.x_max, node.boundary.y_min, node.boundary.y_max);
+    fprintf(file, "%f %f %f %f\n", bd.x_min, bd.x_max, bd.y_min, bd.y_max);
 
     // Exporta recursivamente os nós filhos
-    export_node(node.nw, file);
-    export_node(node.ne, file);
-    export_node(node.sw, file);
-    export_node(node.se, file);
+    if (node.child == INVALIDADDR) return;
+    for (int q = QUAD_NW; q <= QUAD_SE; q++) {
+        export_node(node.child + q, quadtree_child_boundary(&node, &bd, q), file);
+    }
 }
 
 void export_quadtree(const char* filename) {
@@ -311,7 +1273,7 @@ void export_quadtree(const char* filename) {
     }
 
     // Inicia a exportação a partir da raiz da quadtree
-    export_node(root, file);
+    export_node(root, node_boundary(), file);
 
     // Fecha o arquivo após a exportação
     fclose(file);
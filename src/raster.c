@@ -0,0 +1,293 @@
+#include "raster.h"
+
+// Ponto de recarga ativo candidato a mais próximo das células de uma região
+typedef struct {
+    double x;           // Coordenada x do ponto
+    double y;           // Coordenada y do ponto
+} RasterPoint;
+
+// Região do mapa, formada pelas células [i0, i1) x [j0, j1), e seus 
+// candidatos, a ser resolvida por uma thread
+typedef struct {
+    long i0, i1, j0, j1; // Colunas e linhas da região
+    RasterPoint* cands; // Candidatos herdados da região mãe
+    long n;             // Número de candidatos
+} RasterTask;
+
+// Estado compartilhado pelas threads do cálculo do mapa
+typedef struct {
+    const SpatialIndex* ix; // Motor que semeia os candidatos das regiões
+    Boundary bd;        // Limites do mapa
+    long nx, ny;        // Número de colunas e de linhas
+    double cw, ch;      // Largura e altura de cada célula
+    float* dist;        // Distância de cada célula ao ponto ativo mais próximo
+    int32_t* counts;    // Número de pontos ativos de cada célula
+    long* ids;          // Pontos devolvidos pela consulta por janela do motor
+    RasterTask* tasks;  // Regiões a serem resolvidas pelas threads
+    long ntasks;        // Número de regiões
+    long taskcap;       // Capacidade do vetor de regiões
+    atomic_long next;   // Próxima região a ser resolvida
+} RasterJob;
+
+// Função auxiliar que calcula os limites dos centros das células da região
+static Boundary region_centers(const RasterJob* job, long i0, long i1, long j0, long j1) {
+    return (Boundary) {job->bd.x_min + (i0 + 0.5) * job->cw, job->bd.x_min + (i1 - 0.5) * job->cw,
+                       job->bd.y_min + (j0 + 0.5) * job->ch, job->bd.y_min + (j1 - 0.5) * job->ch};
+}
+
+// Função auxiliar que descarta os candidatos que não podem ser o mais 
+// próximo de nenhum ponto do retângulo r: nenhum ponto de r está mais longe
+// do candidato c que sua maior distância a r, de modo que os candidatos cuja
+// menor distância a r excede esse valor (para algum c) são descartados. Os
+// candidatos mantidos são movidos para o início do vetor, sem removê-los, e
+// a função retorna quantos são
+static long region_prune(RasterPoint* cands, long n, const Boundary* r) {
+    double limit = INFINITY;
+    for (long c = 0; c < n; c++) {
+        double dx = fmax(fabs(cands[c].x - r->x_min), fabs(cands[c].x - r->x_max));
+        double dy = fmax(fabs(cands[c].y - r->y_min), fabs(cands[c].y - r->y_max));
+        limit = fmin(limit, dx * dx + dy * dy);
+    }
+    long m = 0;
+    for (long c = 0; c < n; c++) {
+        double dx = fmax(0, fmax(r->x_min - cands[c].x, cands[c].x - r->x_max));
+        double dy = fmax(0, fmax(r->y_min - cands[c].y, cands[c].y - r->y_max));
+        if (dx * dx + dy * dy <= limit) {
+            RasterPoint aux = cands[m];
+            cands[m++] = cands[c];
+            cands[c] = aux;
+        }
+    }
+    return m;
+}
+
+// Função auxiliar que resolve cada célula da região comparando todos os 
+// candidatos
+static void region_fill(RasterJob* job, long i0, long i1, long j0, long j1, const RasterPoint* cands, long n) {
+    for (long j = j0; j < j1; j++) {
+        double y = job->bd.y_min + (j + 0.5) * job->ch;
+        for (long i = i0; i < i1; i++) {
+            double x = job->bd.x_min + (i + 0.5) * job->cw;
+            double best = INFINITY;
+            for (long c = 0; c < n; c++) {
+                double dx = cands[c].x - x;
+                double dy = cands[c].y - y;
+                best = fmin(best, dx * dx + dy * dy);
+            }
+            job->dist[j * job->nx + i] = (float) sqrt(best);
+        }
+    }
+}
+
+// Função auxiliar que acrescenta a região ao vetor de regiões a serem 
+// resolvidas pelas threads
+static void region_add_task(RasterJob* job, RasterTask task) {
+    if (job->ntasks == job->taskcap) {
+        job->taskcap = job->taskcap ? 2 * job->taskcap : 64;
+        job->tasks = (RasterTask*) realloc(job->tasks, job->taskcap * sizeof(RasterTask));
+    }
+    job->tasks[job->ntasks++] = task;
+}
+
+// Função recursiva que resolve a região [i0, i1) x [j0, j1) a partir dos
+// candidatos da região mãe, dividindo-a em quadrantes. Se split for 
+// verdadeiro, as regiões com até RASTER_TASKCELLS células não são 
+// resolvidas, mas copiadas, com seus candidatos, para o vetor de regiões
+static void region_solve(RasterJob* job, long i0, long i1, long j0, long j1, RasterPoint* cands, long n, bool split) {
+    long cells = (i1 - i0) * (j1 - j0);
+    Boundary r = region_centers(job, i0, i1, j0, j1);
+    long m = region_prune(cands, n, &r);
+    if (split && cells <= RASTER_TASKCELLS) {
+        RasterPoint* copy = (RasterPoint*) malloc((m > 0 ? m : 1) * sizeof(RasterPoint));
+        memcpy(copy, cands, m * sizeof(RasterPoint));
+        region_add_task(job, (RasterTask) {i0, i1, j0, j1, copy, m});
+        return;
+    }
+    if (!split && (m <= RASTER_LEAF || cells == 1)) {
+        region_fill(job, i0, i1, j0, j1, cands, m);
+        return;
+    }
+    // Divide a região ao meio nas dimensões com mais de uma célula; os 
+    // quadrantes reordenam apenas os m primeiros candidatos
+    long im = i1 - i0 > 1 ? (i0 + i1) / 2 : i1;
+    long jm = j1 - j0 > 1 ? (j0 + j1) / 2 : j1;
+    long is[3] = {i0, im, i1};
+    long js[3] = {j0, jm, j1};
+    for (int b = 0; b < 2; b++) {
+        for (int a = 0; a < 2; a++) {
+            if (is[a] < is[a + 1] && js[b] < js[b + 1]) {
+                region_solve(job, is[a], is[a + 1], js[b], js[b + 1], cands, m, split);
+            }
+        }
+    }
+}
+
+// Função auxiliar que retorna a maior distância do ponto ativo mais próximo
+// do centro do retângulo r até r (infinita se não houver pontos ativos): 
+// nenhum ponto mais distante de r que isso pode ser o mais próximo de um 
+// ponto de r
+static double region_bound(RasterJob* job, const Boundary* r) {
+    Neighbor nearest;
+    if (spindex_knn(job->ix, (r->x_min + r->x_max) / 2, (r->y_min + r->y_max) / 2, 1, NULL, &nearest) < 1) {
+        return INFINITY;
+    }
+    Item* it = station_get(nearest.id);
+    double dx = fmax(fabs(it->x - r->x_min), fabs(it->x - r->x_max));
+    double dy = fmax(fabs(it->y - r->y_min), fabs(it->y - r->y_max));
+    return sqrt(dx * dx + dy * dy);
+}
+
+// Função recursiva que divide a região [i0, i1) x [j0, j1) em quadrantes até
+// que tenha no máximo RASTER_TASKCELLS células e então a copia para o vetor
+// de regiões, com os candidatos encontrados pela consulta por janela do 
+// motor: os pontos ativos a até radius dos centros da região. O raio vem da
+// região mãe e é reduzido por region_bound na própria região e, ao final, 
+// pelo maior limite dos seus blocos de RASTER_SEEDSIDE x RASTER_SEEDSIDE 
+// células, bem menor que o da região inteira onde os pontos são densos. A
+// janela tem a folga de uma célula, de modo que contém todos os pontos das
+// células da região, que são contados aqui
+static void region_seed(RasterJob* job, long i0, long i1, long j0, long j1, double radius) {
+    long cells = (i1 - i0) * (j1 - j0);
+    Boundary r = region_centers(job, i0, i1, j0, j1);
+    if (cells > RASTER_TASKCELLS) {
+        radius = fmin(radius, region_bound(job, &r));
+        long im = i1 - i0 > 1 ? (i0 + i1) / 2 : i1;
+        long jm = j1 - j0 > 1 ? (j0 + j1) / 2 : j1;
+        long is[3] = {i0, im, i1};
+        long js[3] = {j0, jm, j1};
+        for (int b = 0; b < 2; b++) {
+            for (int a = 0; a < 2; a++) {
+                if (is[a] < is[a + 1] && js[b] < js[b + 1]) {
+                    region_seed(job, is[a], is[a + 1], js[b], js[b + 1], radius);
+                }
+            }
+        }
+        return;
+    }
+    double blocks = 0;
+    for (long bj = j0; bj < j1; bj += RASTER_SEEDSIDE) {
+        for (long bi = i0; bi < i1; bi += RASTER_SEEDSIDE) {
+            Boundary b = region_centers(job, bi, bi + RASTER_SEEDSIDE < i1 ? bi + RASTER_SEEDSIDE : i1,
+                                        bj, bj + RASTER_SEEDSIDE < j1 ? bj + RASTER_SEEDSIDE : j1);
+            blocks = fmax(blocks, region_bound(job, &b));
+        }
+    }
+    radius = fmin(radius, blocks);
+
+    // Sem nenhum ponto ativo, o raio continua infinito
+    long m = isfinite(radius) ? job->ix->window(&r, radius + hypot(job->cw, job->ch), job->ids) : 0;
+    RasterPoint* cands = (RasterPoint*) malloc((m > 0 ? m : 1) * sizeof(RasterPoint));
+    for (long c = 0; c < m; c++) {
+        Item* it = station_get(job->ids[c]);
+        cands[c] = (RasterPoint) {it->x, it->y};
+        long i = (long) floor((it->x - job->bd.x_min) / job->cw);
+        long j = (long) floor((it->y - job->bd.y_min) / job->ch);
+        if (i >= i0 && i < i1 && j >= j0 && j < j1) job->counts[j * job->nx + i]++;
+    }
+    region_add_task(job, (RasterTask) {i0, i1, j0, j1, cands, m});
+}
+
+// Função executada por cada thread: resolve regiões até que não restem mais
+static void* raster_worker(void* arg) {
+    RasterJob* job = (RasterJob*) arg;
+    long t;
+    while ((t = atomic_fetch_add(&job->next, 1)) < job->ntasks) {
+        RasterTask* task = &job->tasks[t];
+        region_solve(job, task->i0, task->i1, task->j0, task->j1, task->cands, task->n, false);
+    }
+    return NULL;
+}
+
+double raster_write(const SpatialIndex* ix, const char* filename, long nx, long ny, Boundary bd, int nthreads) {
+    if (nx < 1 || ny < 1 || nx > RASTER_MAXSIDE || ny > RASTER_MAXSIDE) {
+        fprintf(stderr, "Erro: o mapa deve ter de 1 a %d celulas em cada dimensao\n", RASTER_MAXSIDE);
+        return -1;
+    }
+    if (nthreads < 1) nthreads = 1;
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Erro: nao foi possivel criar o arquivo %s\n", filename);
+        return -1;
+    }
+
+    RasterJob job = {ix, bd, nx, ny, (bd.x_max - bd.x_min) / nx, (bd.y_max - bd.y_min) / ny, NULL, NULL, NULL, 
+                     NULL, 0, 0, 0};
+    job.dist = (float*) malloc(nx * ny * sizeof(float));
+    job.counts = (int32_t*) calloc(nx * ny, sizeof(int32_t));
+    RasterPoint* cands = NULL;
+    if (ix->window != NULL) {
+        job.ids = (long*) malloc((station_count() + 1) * sizeof(long));
+    }
+    else {
+        cands = (RasterPoint*) malloc((station_count() + 1) * sizeof(RasterPoint));
+    }
+    pthread_t* threads = (pthread_t*) malloc(nthreads * sizeof(pthread_t));
+    if (job.dist == NULL || job.counts == NULL || (job.ids == NULL && cands == NULL) || threads == NULL) {
+        fprintf(stderr,"raster_write: could not allocate raster\n");
+        free(job.dist); free(job.counts); free(job.ids); free(cands); free(threads);
+        fclose(file);
+        return -1;
+    }
+
+    // Divide o mapa em regiões, já com seus candidatos, que são semeados 
+    // pelo motor ou, se ele não oferecer consultas por janela, filtrados a 
+    // partir de todos os pontos ativos, contados na cópia
+    if (ix->window != NULL) {
+        region_seed(&job, 0, nx, 0, ny, INFINITY);
+    }
+    else {
+        long n = 0;
+        for (long p = station_next(0, true); p != INVALIDSTATION; p = station_next(p + 1, true)) {
+            Item* it = station_get(p);
+            cands[n++] = (RasterPoint) {it->x, it->y};
+            long i = (long) floor((it->x - bd.x_min) / job.cw);
+            long j = (long) floor((it->y - bd.y_min) / job.ch);
+            if (i >= 0 && i < nx && j >= 0 && j < ny) job.counts[j * nx + i]++;
+        }
+        region_solve(&job, 0, nx, 0, ny, cands, n, true);
+    }
+
+    // Resolve as regiões em paralelo
+    atomic_init(&job.next, 0);
+    int started = 0;
+    for (int i = 1; i < nthreads; i++) {
+        if (pthread_create(&threads[started], NULL, raster_worker, &job) != 0) {
+            fprintf(stderr,"raster_write: could not create thread\n");
+            break;
+        }
+        started++;
+    }
+    // A thread atual também resolve regiões
+    raster_worker(&job);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Grava o cabeçalho e as duas camadas do mapa
+    double maxdist = 0;
+    for (long c = 0; c < nx * ny; c++) {
+        if (isfinite(job.dist[c])) maxdist = fmax(maxdist, job.dist[c]);
+    }
+    int32_t dims[2] = {(int32_t) nx, (int32_t) ny};
+    double limits[4] = {bd.x_min, bd.y_min, bd.x_max, bd.y_max};
+    bool ok = fwrite(RASTER_MAGIC, 1, 4, file) == 4 && fwrite(dims, sizeof(int32_t), 2, file) == 2 &&
+              fwrite(limits, sizeof(double), 4, file) == 4 &&
+              fwrite(job.dist, sizeof(float), nx * ny, file) == (size_t) (nx * ny) &&
+              fwrite(job.counts, sizeof(int32_t), nx * ny, file) == (size_t) (nx * ny);
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "Erro: nao foi possivel gravar o arquivo %s\n", filename);
+        maxdist = -1;
+    }
+
+    for (long t = 0; t < job.ntasks; t++) {
+        free(job.tasks[t].cands);
+    }
+    free(job.tasks);
+    free(job.dist);
+    free(job.counts);
+    free(job.ids);
+    free(cands);
+    free(threads);
+    return maxdist;
+}
@@ -0,0 +1,62 @@
+#include "route.h"
+
+long route_segments(const Route* r) {
+    return r->n > 1 ? r->n - 1 : 1;
+}
+
+// Função auxiliar que calcula a distância do ponto (x, y) ao segmento 
+// (x0, y0)-(x1, y1), projetando o ponto sobre a reta do segmento
+static double segment_point_dist(double x0, double y0, double x1, double y1, double x, double y) {
+    double dx = x1 - x0;
+    double dy = y1 - y0;
+    double len2 = dx * dx + dy * dy;
+    double t = len2 > 0 ? ((x - x0) * dx + (y - y0) * dy) / len2 : 0;
+    // Limita a projeção ao segmento
+    t = fmax(0, fmin(1, t));
+    double px = x0 + t * dx - x;
+    double py = y0 + t * dy - y;
+    return sqrt(px * px + py * py);
+}
+
+double route_segment_dist(const Route* r, long s, double x, double y) {
+    long e = s + 1 < r->n ? s + 1 : s;
+    return segment_point_dist(r->xs[s], r->ys[s], r->xs[e], r->ys[e], x, y);
+}
+
+double route_segment_rect_dist(const Route* r, long s, const Boundary* bd) {
+    long e = s + 1 < r->n ? s + 1 : s;
+    double x0 = r->xs[s], y0 = r->ys[s], x1 = r->xs[e], y1 = r->ys[e];
+    if (boundary_hits_segment(bd, x0, y0, x1, y1)) return 0;
+    // Um segmento e um retângulo disjuntos têm a menor distância entre uma 
+    // extremidade do segmento e o retângulo ou entre um canto do retângulo
+    // e o segmento
+    Boundary b = *bd;
+    double dist = fmin(boundary_min_dist(&b, x0, y0), boundary_min_dist(&b, x1, y1));
+    dist = fmin(dist, segment_point_dist(x0, y0, x1, y1, b.x_min, b.y_min));
+    dist = fmin(dist, segment_point_dist(x0, y0, x1, y1, b.x_min, b.y_max));
+    dist = fmin(dist, segment_point_dist(x0, y0, x1, y1, b.x_max, b.y_min));
+    dist = fmin(dist, segment_point_dist(x0, y0, x1, y1, b.x_max, b.y_max));
+    return dist;
+}
+
+double route_dist(const Route* r, double x, double y) {
+    double dist = INFINITY;
+    for (long s = 0; s < route_segments(r); s++) {
+        dist = fmin(dist, route_segment_dist(r, s, x, y));
+    }
+    return dist;
+}
+
+long route_nearest_vertex(const Route* r, double x, double y) {
+    long best = 0;
+    double bestdist = INFINITY;
+    for (long v = 0; v < r->n; v++) {
+        double dx = r->xs[v] - x;
+        double dy = r->ys[v] - y;
+        if (dx * dx + dy * dy < bestdist) {
+            bestdist = dx * dx + dy * dy;
+            best = v;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,144 @@
+#include "scan.h"
+
+// Variáveis encapsuladas que mantêm os vetores de coordenadas. A posição p
+// dos vetores corresponde ao ponto de recarga p; as posições completadas
+// além de scann têm coordenadas infinitas e nunca são selecionadas
+double* scanxs = NULL; // Coordenadas x dos pontos
+double* scanys = NULL; // Coordenadas y dos pontos
+long scann = 0; // Número de pontos de recarga
+long scanpad = 0; // Tamanho dos vetores, múltiplo de SCAN_LANES
+
+// Funções privadas
+static int cmpknn(const void* a, const void* b);
+
+void scan_build(Boundary bd) {
+    // Os vetores incluem todos os pontos, de modo que os limites não são
+    // usados
+    (void) bd;
+    scan_destroy();
+    long n = station_count();
+    long pad = (n + SCAN_LANES - 1) / SCAN_LANES * SCAN_LANES;
+    if (pad == 0) pad = SCAN_LANES;
+    // Os vetores são alinhados ao tamanho de um vetor SIMD
+    scanxs = (double*) aligned_alloc(sizeof(ScanVec), pad * sizeof(double));
+    scanys = (double*) aligned_alloc(sizeof(ScanVec), pad * sizeof(double));
+    if (scanxs == NULL || scanys == NULL) {
+        fprintf(stderr,"scan_build: could not allocate coordinates\n");
+        scan_destroy();
+        return;
+    }
+    for (long p = 0; p < n; p++) {
+        Item* it = station_get(p);
+        scanxs[p] = it->x;
+        scanys[p] = it->y;
+    }
+    for (long p = n; p < pad; p++) {
+        scanxs[p] = INFINITY;
+        scanys[p] = INFINITY;
+    }
+    scann = n;
+    scanpad = pad;
+}
+
+void scan_destroy() {
+    free(scanxs);
+    free(scanys);
+    scanxs = NULL;
+    scanys = NULL;
+    scann = scanpad = 0;
+}
+
+size_t scan_memory() {
+    return 2 * scanpad * sizeof(double);
+}
+
+long scan_search(char* idend, double x, double y) {
+    // Verifica se os vetores estão vazios
+    if (scanxs == NULL) {
+        fprintf(stderr, "scan_search: scan empty\n");
+        return INVALIDSTATION;
+    }
+    // Compara o identificador apenas dos pontos com as mesmas coordenadas
+    for (long p = 0; p < scann; p++) {
+        if (scanxs[p] == x && scanys[p] == y && !strcmp(station_get(p)->idend, idend)) {
+            return p;
+        }
+    }
+    return INVALIDSTATION;
+}
+
+// Função de comparação para o KNN
+static int cmpknn(const void* a, const void* b) {
+    Neighbor* k1 = (Neighbor*) a;
+    Neighbor* k2 = (Neighbor*) b;
+    // Compara as distâncias dos vizinhos
+    if (k1->dist > k2->dist) return 1;
+    else if (k1->dist < k2->dist) return -1;
+    else return 0;
+}
+
+long scan_knn(double x, double y, long k, const Filter* filter, Neighbor* result) {
+    // Verifica se os vetores estão vazios
+    if (scanxs == NULL) {
+        fprintf(stderr,"scan_knn: scan empty\n");
+        return 0;
+    }
+    if (k <= 0) return 0;
+    Heap* heap = heap_initialize(k);
+    // Replica as coordenadas da consulta em todas as SCAN_LANES posições
+    ScanVec qx = x - (ScanVec) {0};
+    ScanVec qy = y - (ScanVec) {0};
+    // O heap guarda o quadrado das distâncias, e o limiar é o quadrado da
+    // distância do k-ésimo vizinho atual (infinito enquanto houver menos de k)
+    double limit = INFINITY;
+    double d2[SCAN_BLOCK] __attribute__((aligned(sizeof(ScanVec))));
+
+    for (long b = 0; b < scanpad; b += SCAN_BLOCK) {
+        long e = b + SCAN_BLOCK < scanpad ? b + SCAN_BLOCK : scanpad;
+        // Calcula as distâncias do bloco, SCAN_LANES pontos por vez
+        for (long p = b; p < e; p += SCAN_LANES) {
+            ScanVec dx = *(ScanVec*) &scanxs[p] - qx;
+            ScanVec dy = *(ScanVec*) &scanys[p] - qy;
+            *(ScanVec*) &d2[p - b] = dx * dx + dy * dy;
+        }
+        // Apenas os pontos abaixo do limiar precisam ter o status e o filtro
+        // verificados
+        for (long p = b; p < e; p++) {
+            double d = d2[p - b];
+            if (!(d < limit)) continue;
+            if (!station_is_active(p) || !filter_match(filter, p)) continue;
+            if (heap->size == k) heap_pop(heap);
+            heap_push(heap, (Neighbor) {p, d});
+            if (heap->size == k) limit = heap->neighbors[0].dist;
+        }
+    }
+
+    // Converte os quadrados em distâncias, ordena os vizinhos encontrados e
+    // os copia para o array de resultados
+    for (long i = 0; i < heap->size; i++) {
+        heap->neighbors[i].dist = sqrt(heap->neighbors[i].dist);
+    }
+    qsort(heap->neighbors, heap->size, sizeof(Neighbor), cmpknn);
+    memcpy(result, heap->neighbors, heap->size * sizeof(Neighbor));
+    long found = heap->size;
+    heap_destroy(heap);
+    return found;
+}
+
+const SpatialIndex scan_index = {
+    "scan",
+    scan_build,
+    scan_destroy,
+    NULL,
+    scan_search,
+    scan_knn,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    scan_memory
+};
@@ -0,0 +1,296 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include "server.h"
+
+// Número máximo de eventos tratados por chamada a epoll_wait
+#define MAXEVENTS 64
+
+// Estrutura que mantém o estado de uma conexão
+typedef struct Connection {
+    int fd;             // Descritor do socket da conexão
+    char* in;           // Dados recebidos ainda não processados
+    size_t inlen;       // Número de bytes em in
+    size_t incap;       // Capacidade de in
+    char* out;          // Respostas ainda não enviadas
+    size_t outlen;      // Número de bytes em out
+    size_t outpos;      // Bytes de out já enviados
+    size_t outcap;      // Capacidade de out
+    bool eof;           // O cliente encerrou o envio de requisições
+    struct Connection* prev; // Conexão anterior na lista de conexões abertas
+    struct Connection* next; // Próxima conexão na lista de conexões abertas
+} Connection;
+
+// Indica que o servidor recebeu um sinal de encerramento
+static volatile sig_atomic_t stopping = 0;
+
+// Lista das conexões abertas, liberadas ao fim do laço de eventos
+static Connection* connections = NULL;
+
+// Funções privadas
+static void server_on_signal(int sig);
+static int set_nonblocking(int fd);
+static void conn_append(Connection* c, const char* data, size_t len);
+static void conn_process(Connection* c, command_handler handler);
+static bool conn_read(Connection* c);
+static bool conn_write(Connection* c);
+static void conn_close(int epfd, Connection* c);
+
+static void server_on_signal(int sig) {
+    (void) sig;
+    stopping = 1;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Acrescenta dados às respostas pendentes da conexão
+static void conn_append(Connection* c, const char* data, size_t len) {
+    if (c->outlen + len > c->outcap) {
+        while (c->outlen + len > c->outcap) {
+            c->outcap = c->outcap ? 2 * c->outcap : 4096;
+        }
+        c->out = realloc(c->out, c->outcap);
+    }
+    memcpy(c->out + c->outlen, data, len);
+    c->outlen += len;
+}
+
+// Executa todas as requisições completas (terminadas em nova linha) 
+// recebidas na conexão, acumulando as respostas
+static void conn_process(Connection* c, command_handler handler) {
+    // Se o cliente encerrou o envio, uma última linha sem '\n' também é 
+    // executada; conn_read só lê com espaço livre no buffer, de modo que 
+    // sempre cabe mais um byte
+    if (c->eof && c->inlen > 0 && c->in[c->inlen - 1] != '\n') {
+        c->in[c->inlen++] = '\n';
+    }
+    size_t start = 0;
+    for (size_t i = 0; i < c->inlen; i++) {
+        if (c->in[i] != '\n') continue;
+        // Isola a linha, removendo um eventual '\r'
+        c->in[i] = 0;
+        if (i > start && c->in[i - 1] == '\r') c->in[i - 1] = 0;
+        char* line = c->in + start;
+        start = i + 1;
+        if (line[0] == 0) continue;
+
+        // Executa o comando escrevendo a resposta em um buffer em memória
+        char* resp = NULL;
+        size_t resplen = 0;
+        FILE* mem = open_memstream(&resp, &resplen);
+        if (mem == NULL) continue;
+        handler(line, mem);
+        fputc('\n', mem);
+        fclose(mem);
+        conn_append(c, resp, resplen);
+        free(resp);
+    }
+    // Mantém no início do buffer apenas a linha ainda incompleta
+    memmove(c->in, c->in + start, c->inlen - start);
+    c->inlen -= start;
+}
+
+// Lê todos os dados disponíveis na conexão. Retorna falso em caso de erro
+static bool conn_read(Connection* c) {
+    while (true) {
+        if (c->inlen == c->incap) {
+            c->incap = c->incap ? 2 * c->incap : 4096;
+            c->in = realloc(c->in, c->incap);
+        }
+        ssize_t r = read(c->fd, c->in + c->inlen, c->incap - c->inlen);
+        if (r > 0) {
+            c->inlen += r;
+            continue;
+        }
+        if (r == 0) {
+            c->eof = true;
+            return true;
+        }
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+// Envia o máximo possível das respostas pendentes. Retorna falso em caso de
+// erro
+static bool conn_write(Connection* c) {
+    while (c->outpos < c->outlen) {
+        ssize_t w = write(c->fd, c->out + c->outpos, c->outlen - c->outpos);
+        if (w > 0) {
+            c->outpos += w;
+            continue;
+        }
+        if (w < 0 && errno == EINTR) continue;
+        return w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+    c->outpos = c->outlen = 0;
+    return true;
+}
+
+static void conn_close(int epfd, Connection* c) {
+    if (c->prev != NULL) c->prev->next = c->next;
+    else connections = c->next;
+    if (c->next != NULL) c->next->prev = c->prev;
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->in);
+    free(c->out);
+    free(c);
+}
+
+int server_run_socket(const char* path, command_handler handler, commit_handler commit) {
+    // Cria o socket de escuta
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "server_run_socket: socket path too long\n");
+        return -1;
+    }
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        perror("server_run_socket: socket");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(lfd, (struct sockaddr*) &addr, sizeof(addr)) < 0 || listen(lfd, SOMAXCONN) < 0 ||
+        set_nonblocking(lfd) < 0) {
+        perror("server_run_socket: bind");
+        close(lfd);
+        return -1;
+    }
+
+    int epfd = epoll_create1(0);
+    struct epoll_event ev = {0};
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // O socket de escuta é identificado por ptr nulo
+    epoll_ctl(epfd, EPOLL_CTL_ADD, lfd, &ev);
+
+    // Encerra o laço de eventos em SIGINT ou SIGTERM; ignora SIGPIPE para 
+    // tratar clientes que fecham a conexão como erro de escrita
+    struct sigaction sa = {0};
+    sa.sa_handler = server_on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    stopping = 0;
+
+    struct epoll_event events[MAXEVENTS];
+    while (!stopping) {
+        int nev = epoll_wait(epfd, events, MAXEVENTS, -1);
+        if (nev < 0) {
+            if (errno == EINTR) {
+                // Sinais também contam como uma rodada de eventos
+                if (commit != NULL) commit();
+                continue;
+            }
+            perror("server_run_socket: epoll_wait");
+            break;
+        }
+        // Primeiro lê e executa as requisições de todas as conexões prontas
+        for (int e = 0; e < nev; e++) {
+            Connection* c = events[e].data.ptr;
+
+            // Aceita todas as conexões pendentes
+            if (c == NULL) {
+                int cfd;
+                while ((cfd = accept(lfd, NULL, NULL)) >= 0) {
+                    set_nonblocking(cfd);
+                    Connection* nc = calloc(1, sizeof(Connection));
+                    nc->fd = cfd;
+                    nc->next = connections;
+                    if (connections != NULL) connections->prev = nc;
+                    connections = nc;
+                    struct epoll_event cev = {0};
+                    cev.events = EPOLLIN | EPOLLRDHUP;
+                    cev.data.ptr = nc;
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, cfd, &cev);
+                }
+                continue;
+            }
+
+            if ((events[e].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && !c->eof) {
+                if (conn_read(c)) {
+                    conn_process(c, handler);
+                }
+                else {
+                    c->eof = true;
+                    c->outlen = c->outpos = 0; // Erro: descarta as respostas
+                }
+            }
+        }
+
+        // Confirma de uma só vez os efeitos de todos os comandos da rodada
+        if (commit != NULL) commit();
+
+        // Depois envia as respostas
+        for (int e = 0; e < nev; e++) {
+            Connection* c = events[e].data.ptr;
+            if (c == NULL) continue;
+
+            bool ok = conn_write(c);
+            if (!ok || (events[e].events & EPOLLERR) || (c->eof && c->outlen == 0)) {
+                conn_close(epfd, c);
+                continue;
+            }
+
+            // Só aguarda a possibilidade de escrita enquanto houver respostas
+            // pendentes; após o fim das requisições, aguarda apenas a escrita
+            struct epoll_event cev = {0};
+            cev.events = (c->eof ? 0 : EPOLLIN | EPOLLRDHUP) | (c->outlen > 0 ? EPOLLOUT : 0);
+            cev.data.ptr = c;
+            epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &cev);
+        }
+    }
+
+    // Fecha as conexões que continuam abertas no encerramento
+    while (connections != NULL) {
+        conn_close(epfd, connections);
+    }
+    close(epfd);
+    close(lfd);
+    unlink(path);
+    return 0;
+}
+
+int server_run_stdio(command_handler handler, commit_handler commit) {
+    char* line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    // Atende uma requisição por linha até o fim da entrada
+    for (;;) {
+        errno = 0;
+        len = getline(&line, &cap, stdin);
+        if (len < 0) {
+            // Uma leitura interrompida por sinal não encerra o servidor; o 
+            // sinal conta como uma rodada de eventos
+            if (errno == EINTR && !feof(stdin)) {
+                clearerr(stdin);
+                if (commit != NULL) commit();
+                continue;
+            }
+            break;
+        }
+        line[strcspn(line, "\r\n")] = 0;
+        if (line[0] == 0) continue;
+        handler(line, stdout);
+        if (commit != NULL) commit();
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+    free(line);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "spindex.h"
+#include "quadtree.h"
+#include "kdtree.h"
+#include "grid.h"
+#include "scan.h"
+#include "autoindex.h"
+#include "tiles.h"
+
+// Motores disponíveis; o primeiro é o padrão
+static const SpatialIndex* engines[] = {
+    &quadtree_index,
+    &kdtree_index,
+    &grid_index,
+    &scan_index,
+    &auto_index,
+    NULL
+};
+
+const SpatialIndex* spindex_find(const char* name) {
+    // Sem nome, retorna o motor padrão
+    if (name == NULL) return engines[0];
+    for (int i = 0; engines[i] != NULL; i++) {
+        if (!strcmp(engines[i]->name, name)) {
+            return engines[i];
+        }
+    }
+    return NULL;
+}
+
+void spindex_list(FILE* out) {
+    for (int i = 0; engines[i] != NULL; i++) {
+        fprintf(out, "%s%s", i ? ", " : "", engines[i]->name);
+    }
+    fprintf(out, "\n");
+}
+
+void spindex_set_active(const SpatialIndex* ix, long id, bool ativo) {
+    // O estado de atividade pertence ao ponto de recarga, não ao índice, que
+    // é notificado apenas se o status mudou
+    if (station_set_active(id, ativo, ix->set_active)) {
+        tiles_set_active(id, ativo);
+    }
+}
+
+long spindex_set_active_list(const SpatialIndex* ix, const long* ids, long n, bool ativo, long* changed) {
+    long nchanged = station_set_active_list(ids, n, ativo, changed, ix->set_active);
+    for (long i = 0; i < nchanged; i++) {
+        tiles_set_active(changed[i], ativo);
+    }
+    return nchanged;
+}
+
+long spindex_knn(const SpatialIndex* ix, double x, double y, long k, const Filter* filter, Neighbor* result) {
+    return ix->knn(x, y, k, filter, result);
+}
+
+void spindex_knn_batch(const SpatialIndex* ix, const double* xs, const double* ys, const long* ks, long nq,
+                       Neighbor** result, long* found) {
+    // Sem consultas intercaladas, executa as consultas uma a uma
+    if (ix->knn_batch != NULL) {
+        ix->knn_batch(xs, ys, ks, nq, result, found);
+        return;
+    }
+    for (long i = 0; i < nq; i++) {
+        found[i] = ix->knn(xs[i], ys[i], ks[i], NULL, result[i]);
+    }
+}
+
+// Função auxiliar que encontra os pontos ativos dentro do polígono, 
+// percorrendo todos os pontos se o motor não oferece consultas por polígono
+static long spindex_run_polygon(const SpatialIndex* ix, const Polygon* poly, long* ids) {
+    if (ix->polygon != NULL) {
+        return ix->polygon(poly, ids);
+    }
+    long n = 0;
+    for (long i = station_next(0, true); i != INVALIDSTATION; i = station_next(i + 1, true)) {
+        Item* it = station_get(i);
+        if (polygon_contains(poly, it->x, it->y)) {
+            if (ids != NULL) ids[n] = i;
+            n++;
+        }
+    }
+    return n;
+}
+
+// Função de comparação para ordenar identificadores
+static int cmp_id(const void* a, const void* b) {
+    long i1 = *(const long*) a;
+    long i2 = *(const long*) b;
+    return (i1 > i2) - (i1 < i2);
+}
+
+long spindex_polygon(const SpatialIndex* ix, const Polygon* poly, long* ids) {
+    long n = spindex_run_polygon(ix, poly, ids);
+    if (ids != NULL) {
+        qsort(ids, n, sizeof(long), cmp_id);
+    }
+    return n;
+}
+
+// Função auxiliar que encontra os pontos ativos a até d da rota, percorrendo
+// todos os pontos se o motor não oferece consultas por corredor
+static long spindex_run_corridor(const SpatialIndex* ix, const Route* route, double d, Neighbor* result) {
+    if (ix->corridor != NULL) {
+        return ix->corridor(route, d, result);
+    }
+    long n = 0;
+    for (long i = station_next(0, true); i != INVALIDSTATION; i = station_next(i + 1, true)) {
+        Item* it = station_get(i);
+        double dist = route_dist(route, it->x, it->y);
+        if (dist <= d) {
+            result[n++] = (Neighbor) {i, dist};
+        }
+    }
+    return n;
+}
+
+// Função de comparação que ordena os pontos do corredor pela distância à 
+// rota e, em caso de empate, pelo identificador
+static int cmp_corridor(const void* a, const void* b) {
+    const Neighbor* n1 = (const Neighbor*) a;
+    const Neighbor* n2 = (const Neighbor*) b;
+    if (n1->dist != n2->dist) return n1->dist > n2->dist ? 1 : -1;
+    return (n1->id > n2->id) - (n1->id < n2->id);
+}
+
+long spindex_corridor(const SpatialIndex* ix, const Route* route, double d, Neighbor* result) {
+    long n = spindex_run_corridor(ix, route, d, result);
+    qsort(result, n, sizeof(Neighbor), cmp_corridor);
+    return n;
+}
@@ -0,0 +1,228 @@
+#include "station.h"
+
+// Variáveis encapsuladas que mantêm o vetor de pontos de recarga
+Item* stationvet = NULL; // Vetor de pontos de recarga
+long stationvetsz = 0; // Capacidade do vetor
+long stationsallocated = 0; // Número de pontos de recarga armazenados
+atomic_uint_fast64_t* activebits = NULL; // Status de atividade, um bit por ponto
+long* bairroids = NULL; // Identificadores ordenados por bairro, criado sob demanda
+Arena stationarena = EMPTYARENA; // Strings dos pontos de recarga
+
+long station_initialize(long numstations) {
+    // Aloca o vetor de pontos de recarga
+    stationvet = (Item*) malloc(numstations * sizeof(Item));
+    if (stationvet == NULL) {
+        fprintf(stderr,"station_initialize: could not allocate stationvet\n");
+        return 0;
+    }
+    // Aloca o vetor de bits de atividade, com uma palavra a mais para que a
+    // varredura não precise tratar o final separadamente
+    activebits = (atomic_uint_fast64_t*) calloc(numstations / 64 + 1, sizeof(atomic_uint_fast64_t));
+    if (activebits == NULL) {
+        fprintf(stderr,"station_initialize: could not allocate activebits\n");
+        free(stationvet);
+        stationvet = NULL;
+        return 0;
+    }
+    stationvetsz = numstations;
+    stationsallocated = 0;
+    return numstations;
+}
+
+long station_add(Item* it) {
+    // Verifica se ainda há espaço no vetor
+    if (stationsallocated >= stationvetsz) {
+        fprintf(stderr,"station_add: stationvet full\n");
+        return INVALIDSTATION;
+    }
+    stationvet[stationsallocated] = *it;
+    // O ponto de recarga começa ativo
+    atomic_fetch_or_explicit(&activebits[stationsallocated / 64], 
+                             (uint64_t) 1 << (stationsallocated % 64), memory_order_relaxed);
+    // O índice por bairro deixa de refletir o vetor
+    free(bairroids);
+    bairroids = NULL;
+    return stationsallocated++;
+}
+
+long station_add_block(long n) {
+    // Verifica se ainda há espaço no vetor
+    if (n < 0 || stationsallocated + n > stationvetsz) {
+        fprintf(stderr,"station_add_block: stationvet full\n");
+        return INVALIDSTATION;
+    }
+    // Os pontos de recarga começam ativos
+    for (long i = stationsallocated; i < stationsallocated + n; i++) {
+        atomic_fetch_or_explicit(&activebits[i / 64], (uint64_t) 1 << (i % 64), memory_order_relaxed);
+    }
+    // O índice por bairro deixa de refletir o vetor
+    free(bairroids);
+    bairroids = NULL;
+    long first = stationsallocated;
+    stationsallocated += n;
+    return first;
+}
+
+Item* station_get(long id) {
+    // Verifica se o identificador é válido
+    if (id < 0 || id >= stationsallocated) {
+        fprintf(stderr,"station_get: id out of range\n");
+        return NULL;
+    }
+    return &(stationvet[id]);
+}
+
+long station_count() {
+    return stationsallocated;
+}
+
+Boundary station_boundary() {
+    if (stationsallocated == 0) return (Boundary) {0, 1, 0, 1};
+    Boundary bd = {stationvet[0].x, stationvet[0].x, stationvet[0].y, stationvet[0].y};
+    for (long i = 1; i < stationsallocated; i++) {
+        bd.x_min = fmin(bd.x_min, stationvet[i].x);
+        bd.x_max = fmax(bd.x_max, stationvet[i].x);
+        bd.y_min = fmin(bd.y_min, stationvet[i].y);
+        bd.y_max = fmax(bd.y_max, stationvet[i].y);
+    }
+    bd.x_max = nextafter(bd.x_max, INFINITY);
+    bd.y_max = nextafter(bd.y_max, INFINITY);
+    return bd;
+}
+
+char* station_strdup(const char* s) {
+    return arena_strdup(&stationarena, s);
+}
+
+void station_adopt_strings(Arena* a) {
+    arena_merge(&stationarena, a);
+}
+
+void station_destroy() {
+    free(stationvet);
+    free(activebits);
+    free(bairroids);
+    arena_release(&stationarena);
+    stationvet = NULL;
+    activebits = NULL;
+    bairroids = NULL;
+    stationvetsz = 0;
+    stationsallocated = 0;
+}
+
+bool station_is_active(long id) {
+    uint64_t word = atomic_load_explicit(&activebits[id / 64], memory_order_relaxed);
+    return (word >> (id % 64)) & 1;
+}
+
+// Função auxiliar que altera o bit de atividade de id
+static void station_store_active(long id, bool ativo) {
+    uint64_t mask = (uint64_t) 1 << (id % 64);
+    if (ativo) {
+        atomic_fetch_or_explicit(&activebits[id / 64], mask, memory_order_relaxed);
+    }
+    else {
+        atomic_fetch_and_explicit(&activebits[id / 64], ~mask, memory_order_relaxed);
+    }
+}
+
+bool station_set_active(long id, bool ativo, station_notify notify) {
+    bool changed = station_is_active(id) != ativo;
+    if (changed) {
+        station_store_active(id, ativo);
+        if (notify != NULL) notify(id, ativo);
+    }
+    return changed;
+}
+
+long station_set_active_list(const long* ids, long n, bool ativo, long* changed, station_notify notify) {
+    long nchanged = 0;
+    for (long i = 0; i < n; i++) {
+        if (station_is_active(ids[i]) != ativo) {
+            station_store_active(ids[i], ativo);
+            if (notify != NULL) notify(ids[i], ativo);
+            changed[nchanged++] = ids[i];
+        }
+    }
+    return nchanged;
+}
+
+long station_count_active() {
+    // Os bits além do último ponto de recarga são sempre zero
+    long count = 0;
+    for (long w = 0; w <= stationsallocated / 64; w++) {
+        count += __builtin_popcountll(atomic_load_explicit(&activebits[w], memory_order_relaxed));
+    }
+    return count;
+}
+
+long station_next(long from, bool ativo) {
+    if (from < 0) from = 0;
+    long w = from / 64;
+    long nwords = stationsallocated / 64 + 1;
+    // Máscara que descarta os bits anteriores a from na primeira palavra
+    uint64_t mask = ~(uint64_t) 0 << (from % 64);
+    for (; w < nwords; w++, mask = ~(uint64_t) 0) {
+        uint64_t word = atomic_load_explicit(&activebits[w], memory_order_relaxed);
+        // Para procurar pontos inativos, inverte a palavra
+        if (!ativo) word = ~word;
+        word &= mask;
+        if (word != 0) {
+            long id = w * 64 + __builtin_ctzll(word);
+            return id < stationsallocated ? id : INVALIDSTATION;
+        }
+    }
+    return INVALIDSTATION;
+}
+
+// Função de comparação que ordena identificadores por bairro e, dentro do
+// mesmo bairro, pelo próprio identificador
+static int cmpbairro(const void* a, const void* b) {
+    long i = *(const long*) a;
+    long j = *(const long*) b;
+    int c = strcmp(stationvet[i].nome_bairr, stationvet[j].nome_bairr);
+    if (c != 0) return c;
+    return (i > j) - (i < j);
+}
+
+const long* station_bairro(const char* bairro, long* n) {
+    *n = 0;
+    // Cria o índice por bairro na primeira consulta
+    if (bairroids == NULL) {
+        bairroids = (long*) malloc((stationsallocated + 1) * sizeof(long));
+        if (bairroids == NULL) {
+            fprintf(stderr,"station_bairro: could not allocate bairroids\n");
+            return NULL;
+        }
+        for (long i = 0; i < stationsallocated; i++) {
+            bairroids[i] = i;
+        }
+        qsort(bairroids, stationsallocated, sizeof(long), cmpbairro);
+    }
+    // Busca binária pelo primeiro identificador do bairro
+    long lo = 0, hi = stationsallocated;
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (strcmp(stationvet[bairroids[mid]].nome_bairr, bairro) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    long end = lo;
+    while (end < stationsallocated && !strcmp(stationvet[bairroids[end]].nome_bairr, bairro)) {
+        end++;
+    }
+    *n = end - lo;
+    return &bairroids[lo];
+}
+
+size_t station_memory() {
+    if (stationvet == NULL) return 0;
+    return stationvetsz * sizeof(Item) + (stationvetsz / 64 + 1) * sizeof(atomic_uint_fast64_t);
+}
+
+size_t station_strings_memory() {
+    return arena_memory(&stationarena);
+}
+
+size_t station_cache_memory() {
+    return bairroids != NULL ? (stationsallocated + 1) * sizeof(long) : 0;
+}
@@ -0,0 +1,129 @@
+#include "tiles.h"
+
+// Variáveis encapsuladas que mantêm a pirâmide. Os tiles do nível z ocupam
+// as posições [tiles_offset(z), tiles_offset(z + 1)) dos vetores, linha a 
+// linha
+double tilex = 0; // Coordenada x do canto inferior esquerdo da pirâmide
+double tiley = 0; // Coordenada y do canto inferior esquerdo da pirâmide
+double tileside = 0; // Lado do quadrado coberto pela pirâmide
+int32_t* tiletotal = NULL; // Número de pontos de recarga de cada tile
+int32_t* tileactive = NULL; // Número de pontos de recarga ativos de cada tile
+
+// Retorna a posição do primeiro tile do nível z, isto é, o número de tiles
+// dos níveis anteriores (1 + 4 + ... + 4^(z - 1))
+static long tiles_offset(int z) {
+    return ((1L << (2 * z)) - 1) / 3;
+}
+
+// Função auxiliar que retorna a coluna (ou a linha) do nível mais detalhado
+// que contém a coordenada v, a partir da origem v0, limitada à pirâmide
+static long tiles_cell(double v, double v0) {
+    long n = 1L << TILES_MAXZOOM;
+    long c = (long) floor((v - v0) / tileside * n);
+    if (c < 0) return 0;
+    if (c >= n) return n - 1;
+    return c;
+}
+
+// Função auxiliar que soma delta aos contadores dos tiles que contêm o 
+// ponto (x, y), em todos os níveis
+static void tiles_add(int32_t* counts, double x, double y, int32_t delta) {
+    long i = tiles_cell(x, tilex);
+    long j = tiles_cell(y, tiley);
+    for (int z = TILES_MAXZOOM; z >= 0; z--) {
+        counts[tiles_offset(z) + (j << z) + i] += delta;
+        i >>= 1;
+        j >>= 1;
+    }
+}
+
+void tiles_build(Boundary bd) {
+    tiles_destroy();
+    long size = tiles_offset(TILES_MAXZOOM + 1);
+    tiletotal = (int32_t*) calloc(size, sizeof(int32_t));
+    tileactive = (int32_t*) calloc(size, sizeof(int32_t));
+    if (tiletotal == NULL || tileactive == NULL) {
+        fprintf(stderr,"tiles_build: could not allocate tiles\n");
+        tiles_destroy();
+        return;
+    }
+    // Os tiles são quadrados: o lado menor dos limites é estendido
+    tilex = bd.x_min;
+    tiley = bd.y_min;
+    tileside = fmax(bd.x_max - bd.x_min, bd.y_max - bd.y_min);
+    if (!(tileside > 0)) tileside = 1;
+
+    // Conta os pontos no nível mais detalhado
+    int32_t* total = tiletotal + tiles_offset(TILES_MAXZOOM);
+    int32_t* active = tileactive + tiles_offset(TILES_MAXZOOM);
+    long n = station_count();
+    for (long p = 0; p < n; p++) {
+        Item* it = station_get(p);
+        long c = (tiles_cell(it->y, tiley) << TILES_MAXZOOM) + tiles_cell(it->x, tilex);
+        total[c]++;
+        if (station_is_active(p)) active[c]++;
+    }
+
+    // Cada tile dos níveis superiores soma os quatro tiles abaixo dele
+    for (int z = TILES_MAXZOOM - 1; z >= 0; z--) {
+        long side = 1L << z;
+        long up = tiles_offset(z), down = tiles_offset(z + 1);
+        for (long j = 0; j < side; j++) {
+            for (long i = 0; i < side; i++) {
+                long c0 = down + ((2 * j) << (z + 1)) + 2 * i;
+                long c1 = c0 + (side << 1);
+                tiletotal[up + (j << z) + i] = tiletotal[c0] + tiletotal[c0 + 1] + tiletotal[c1] + tiletotal[c1 + 1];
+                tileactive[up + (j << z) + i] = tileactive[c0] + tileactive[c0 + 1] + tileactive[c1] + tileactive[c1 + 1];
+            }
+        }
+    }
+}
+
+void tiles_destroy() {
+    free(tiletotal);
+    free(tileactive);
+    tiletotal = NULL;
+    tileactive = NULL;
+    tilex = tiley = tileside = 0;
+}
+
+void tiles_set_active(long id, bool ativo) {
+    if (tileactive == NULL) return;
+    Item* it = station_get(id);
+    tiles_add(tileactive, it->x, it->y, ativo ? 1 : -1);
+}
+
+size_t tiles_memory() {
+    if (tiletotal == NULL) return 0;
+    return 2 * tiles_offset(TILES_MAXZOOM + 1) * sizeof(int32_t);
+}
+
+long tiles_write(FILE* out, int zoom, const Boundary* view) {
+    if (tiletotal == NULL || zoom < 0 || zoom > TILES_MAXZOOM) return -1;
+    long side = 1L << zoom;
+    double w = tileside / side;
+    // Restringe as colunas e linhas às que interceptam o retângulo
+    long i0 = 0, i1 = side - 1, j0 = 0, j1 = side - 1;
+    if (view != NULL) {
+        if (view->x_max < tilex || view->y_max < tiley || 
+            view->x_min > tilex + tileside || view->y_min > tiley + tileside) {
+            return 0;
+        }
+        i0 = (long) fmax(0, floor((view->x_min - tilex) / w));
+        i1 = (long) fmin(side - 1, floor((view->x_max - tilex) / w));
+        j0 = (long) fmax(0, floor((view->y_min - tiley) / w));
+        j1 = (long) fmin(side - 1, floor((view->y_max - tiley) / w));
+    }
+    long written = 0;
+    long base = tiles_offset(zoom);
+    for (long j = j0; j <= j1; j++) {
+        for (long i = i0; i <= i1; i++) {
+            long c = base + (j << zoom) + i;
+            if (tiletotal[c] == 0) continue;
+            fprintf(out, "%ld %ld %lf %lf %lf %lf %d %d\n", i, j, tilex + i * w, tiley + j * w,
+                    tilex + (i + 1) * w, tiley + (j + 1) * w, tileactive[c], tiletotal[c] - tileactive[c]);
+            written++;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,59 @@
+// biuaidi_client
+// Cliente simples para o modo servidor do biuaidi.
+//
+// Uso:
+// biuaidi_client <socket>
+//
+// Envia ao servidor todas as linhas lidas da entrada padrão, sem esperar as 
+// respostas, e escreve na saída padrão tudo o que o servidor responder até
+// fechar a conexão.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+int main(int argc, char** argv) 
+{
+    if (argc != 2) {
+        fprintf(stderr, "Uso: %s <socket>\n", argv[0]);
+        return 1;
+    }
+
+    // Conecta ao socket do servidor
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, argv[1], sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0) {
+        perror("Erro: nao foi possivel conectar ao servidor");
+        return 1;
+    }
+
+    // Envia todas as requisições e sinaliza o fim do envio
+    char buffer[4096];
+    size_t r;
+    while ((r = fread(buffer, 1, sizeof(buffer), stdin)) > 0) {
+        size_t sent = 0;
+        while (sent < r) {
+            ssize_t w = write(fd, buffer + sent, r - sent);
+            if (w <= 0) {
+                perror("Erro: falha ao enviar requisicoes");
+                return 1;
+            }
+            sent += w;
+        }
+    }
+    shutdown(fd, SHUT_WR);
+
+    // Copia as respostas para a saída padrão
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        fwrite(buffer, 1, n, stdout);
+    }
+    close(fd);
+    return 0;
+}
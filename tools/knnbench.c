@@ -0,0 +1,73 @@
+// knnbench
+// Medição do tempo das consultas kNN da quadtree e da varredura linear, 
+// usada para escolher os limiares do motor "auto" (autoindex.c).
+//
+// Uso:
+// knnbench <arquivo_base> [<consultas>]
+//
+// Para cada k em 1, 2, 4, ..., 4096 (até o número de pontos da base), 
+// executa <consultas> consultas (1000 por padrão) próximas de pontos de 
+// recarga sorteados, com todos os pontos ativos, e imprime o tempo médio por
+// consulta de cada motor, em nanossegundos, o motor escolhido pelo "auto" e
+// o número de vizinhos a partir do qual ele passa a usar a varredura.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "loader.h"
+#include "filter.h"
+#include "quadtree.h"
+#include "scan.h"
+#include "autoindex.h"
+
+// Função que retorna o instante atual, em nanossegundos
+static double now_ns() 
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// Função que mede o tempo médio, em nanossegundos, de nq consultas pelos k 
+// vizinhos mais próximos com a função knn; as consultas são as mesmas para
+// todos os motores
+static double measure(long (*knn)(double, double, long, const Filter*, Neighbor*), long n, long k, int nq, 
+                      Neighbor* result) 
+{
+    srand(1);
+    double start = now_ns();
+    for (int q = 0; q < nq; q++) {
+        Item* it = station_get(rand() % n);
+        knn(it->x + 1, it->y - 1, k, NULL, result);
+    }
+    return (now_ns() - start) / nq;
+}
+
+int main(int argc, char** argv) 
+{
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <arquivo_base> [<consultas>]\n", argv[0]);
+        return 1;
+    }
+    int nq = argc > 2 ? atoi(argv[2]) : 1000;
+    long n = loader_read_base(argv[1], 1);
+    if (n <= 0) return 1;
+    filter_build();
+    Boundary bd = station_boundary();
+    quadtree_index.build(bd);
+    scan_build(bd);
+
+    Neighbor* result = malloc(4096 * sizeof(Neighbor));
+    printf("%8s %6s %12s %12s %8s\n", "n", "k", "quadtree", "scan", "auto");
+    for (long k = 1; k <= 4096 && k <= n; k *= 2) {
+        double tq = measure(quadtree_knn, n, k, nq, result);
+        double ts = measure(scan_knn, n, k, nq, result);
+        printf("%8ld %6ld %12.0f %12.0f %8s\n", n, k, tq, ts, autoindex_use_scan(k) ? "scan" : "quadtree");
+    }
+    printf("limiar do motor auto: k = %.1f\n", autoindex_crossover(n));
+    free(result);
+    scan_destroy();
+    quadtree_destroy();
+    station_destroy();
+    return 0;
+}